@@ -36,13 +36,17 @@ void setup() {
 
 /**
  * @brief Main loop: echo received characters.
+ *
+ * The CPU sleeps until an interrupt arrives instead of spinning on available().
  */
 void loop() {
-    if (serial.available()) {
-        int c = serial.read();
-        if (c >= 0) {
-            serial.write((uint8_t)c);  // Echo back
-        }
+    if (!serial.available()) {
+        __WFI();  // Woken by the UART RX interrupt
+        return;
+    }
+    int c = serial.read();
+    if (c >= 0) {
+        serial.write((uint8_t)c);  // Echo back
     }
 }
 
@@ -62,6 +66,14 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
         inst->handleTxComplete();
 }
 
+/**
+ * @brief HAL error callback (overrun, framing, noise or parity error)
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
+    if (auto inst = STM32BufferedSerial::fromHandle(huart))
+        inst->handleError();
+}
+
 /**
  * @brief Main entry point.
  */
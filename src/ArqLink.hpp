@@ -0,0 +1,236 @@
+/**
+ * @file ArqLink.hpp
+ * @brief Selective-repeat ARQ link layer on top of STM32BufferedSerial.
+ *
+ * Turns a lossy byte stream (radio modem, long RS-485 run, ...) into a
+ * reliable, ordered message channel between two peers.
+ *
+ * Frame format (HDLC-style byte stuffing from Hdlc.hpp, 0x7E delimits, 0x7D escapes):
+ * @code
+ * 0x7E | ctrl | seq | ack | sack(4, LE) | [base] | payload(0..MTU) | crc16(2, LE) | 0x7E
+ * @endcode
+ * - ctrl: bit0 DATA (payload present), bit1 SYN (base follows), bit2 ACK
+ *   (ack / sack valid), bit3 RESYNC (sender has not synchronised its receiver)
+ * - ack:  next in-order sequence number expected by the sender of the frame
+ * - sack: bit i set = sequence ack+1+i has been received out of order
+ * - base: oldest unacknowledged sequence of the sender (SYN frames only)
+ * - crc16: crc16Modbus() over ctrl .. payload
+ *
+ * Data frames carry SYN until the peer acknowledges one of them, so a
+ * receiver starts (or restarts after the peer was reset) at the sender's
+ * window base. A receiver that gets data before any SYN answers with
+ * RESYNC, which makes the sender add SYN again.
+ *
+ * Every frame carries the current ack/sack, so acknowledgements ride on
+ * data going the other way; a pure ACK is sent only when no data left
+ * within STM32BS_ARQ_ACK_DELAY_MS. Pure ACKs use the highest TX lane so
+ * they are not queued behind bulk data.
+ *
+ * The retransmit timeout follows Jacobson/Karels (SRTT + 4 * RTTVAR) with
+ * Karn's rule (no RTT sample from retransmitted frames) and exponential
+ * back-off on timeout; the back-off is dropped again once the window moves.
+ * A frame is also resent at once when a frame sent after it is SACKed,
+ * since the wire keeps order.
+ *
+ * Typical usage:
+ * @code
+ * ArqLink link(serial);
+ * link.begin();
+ *
+ * while (1) {
+ *     link.poll();
+ *     uint8_t msg[STM32BS_ARQ_MTU];
+ *     int n = link.receive(msg, sizeof(msg));
+ *     if (n > 0) handle(msg, n);
+ *     if (haveData && link.send(data, len)) haveData = false;
+ * }
+ * @endcode
+ *
+ * @note Both ends must use the same STM32BS_ARQ_* settings, and TX lane 0 must
+ *       hold at least one stuffed frame (2 * (MTU + 10) + 2 bytes).
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_ARQ_LINK_HPP
+#define STM32_BUFFERED_SERIAL_ARQ_LINK_HPP
+
+#include "STM32BufferedSerial.hpp"
+#include "Hdlc.hpp"
+#include <cstdint>
+
+#ifndef STM32BS_ARQ_WINDOW
+/** Frames in flight per direction (power of two, 1-32). Also the number of TX and RX pool slots. */
+#define STM32BS_ARQ_WINDOW 8
+#endif
+
+#ifndef STM32BS_ARQ_MTU
+/** Maximum payload bytes per frame. */
+#define STM32BS_ARQ_MTU 64
+#endif
+
+#ifndef STM32BS_ARQ_RTO_INIT_MS
+/** Retransmit timeout before the first RTT sample. */
+#define STM32BS_ARQ_RTO_INIT_MS 200
+#endif
+
+#ifndef STM32BS_ARQ_RTO_MIN_MS
+/** Lower bound of the retransmit timeout. */
+#define STM32BS_ARQ_RTO_MIN_MS 10
+#endif
+
+#ifndef STM32BS_ARQ_RTO_MAX_MS
+/** Upper bound of the retransmit timeout (also the back-off ceiling). */
+#define STM32BS_ARQ_RTO_MAX_MS 2000
+#endif
+
+#ifndef STM32BS_ARQ_ACK_DELAY_MS
+/** How long a pending ACK waits for outgoing data to ride on. */
+#define STM32BS_ARQ_ACK_DELAY_MS 2
+#endif
+
+#ifndef STM32BS_ARQ_MAX_RETRIES
+/** Retransmissions of one frame after which isLinkUp() reports false. */
+#define STM32BS_ARQ_MAX_RETRIES 8
+#endif
+
+/**
+ * @class ArqLink
+ * @brief Reliable ordered message link with a selective-repeat sliding window.
+ */
+class ArqLink {
+public:
+    static constexpr uint8_t WINDOW = STM32BS_ARQ_WINDOW; /**< Window size in frames */
+    static constexpr uint16_t MTU = STM32BS_ARQ_MTU;      /**< Maximum payload per frame */
+
+    static_assert(WINDOW >= 1 && WINDOW <= 32 && (WINDOW & (WINDOW - 1)) == 0,
+                  "STM32BS_ARQ_WINDOW must be a power of two up to 32 (SACK bitmap width)");
+    static_assert(MTU >= 1 && MTU <= 1024, "STM32BS_ARQ_MTU must be 1-1024");
+
+    /** @brief Link counters. */
+    struct Stats {
+        uint32_t framesSent;      /**< Data frames sent, including retransmissions */
+        uint32_t retransmissions; /**< Data frames sent again (timeout or SACK hole) */
+        uint32_t acksSent;        /**< Pure ACK frames sent */
+        uint32_t framesReceived;  /**< Frames received with a valid CRC */
+        uint32_t crcErrors;       /**< Frames dropped because of a CRC mismatch or bad length */
+        uint32_t duplicates;      /**< Data frames received twice or outside the window */
+        uint32_t delivered;       /**< Messages returned by receive() */
+    };
+
+    /**
+     * @brief Construct an ARQ link.
+     * @param serial Serial port carrying the frames (exclusively).
+     */
+    explicit ArqLink(STM32BufferedSerial& serial);
+
+    /** @brief Reset both directions. The first frames carry SYN so the peer resynchronises. */
+    void begin();
+
+    /** @brief Receive frames, send ACKs and retransmit on timeout. Call from the main loop. */
+    void poll();
+
+    /**
+     * @brief Queue one message for reliable delivery.
+     * @param data Message bytes.
+     * @param len Message length (1..MTU).
+     * @return false if the window is full or @p len is out of range.
+     */
+    bool send(const uint8_t* data, uint16_t len);
+
+    /**
+     * @brief Take the next in-order message.
+     * @param dst Destination buffer.
+     * @param maxLen Size of @p dst; a longer message is truncated.
+     * @return Message length, or -1 if none is ready.
+     */
+    int receive(uint8_t* dst, uint16_t maxLen);
+
+    /** @brief Number of messages send() can accept now. */
+    uint8_t sendable() const;
+
+    /** @brief true when every sent message has been acknowledged. */
+    bool isIdle() const { return _txBase == _txNext; }
+
+    /** @brief false once a frame was retransmitted STM32BS_ARQ_MAX_RETRIES times without ACK. */
+    bool isLinkUp() const { return _linkUp; }
+
+    /** @brief Current retransmit timeout in ms. */
+    uint32_t rtoMs() const { return _rto; }
+
+    /** @brief Smoothed round-trip time in ms (0 before the first sample). */
+    uint32_t srttMs() const { return _srtt >> 3; }
+
+    /** @brief Link counters. */
+    const Stats& getStats() const { return _stats; }
+
+private:
+    static constexpr uint8_t HEADER = 7;                    /**< ctrl + seq + ack + sack */
+    static constexpr uint16_t MAX_RAW = HEADER + 1 + MTU + 2; /**< Unstuffed frame incl. base and CRC */
+
+    /** @brief One TX pool slot (indexed by seq % WINDOW). */
+    struct TxSlot {
+        uint8_t data[MTU];   /**< Payload */
+        uint16_t len;        /**< Payload length */
+        uint32_t sentAt;     /**< HAL tick of the last transmission */
+        uint8_t tries;       /**< Transmissions so far (0 = not sent yet) */
+        bool acked;          /**< Selectively or cumulatively acknowledged */
+        bool lost;           /**< A later frame was acknowledged: resend without waiting for RTO */
+    };
+
+    /** @brief One RX pool slot (indexed by seq % WINDOW). */
+    struct RxSlot {
+        uint8_t data[MTU];   /**< Payload */
+        uint16_t len;        /**< Payload length */
+        bool full;           /**< Holds a received, undelivered message */
+    };
+
+    STM32BufferedSerial& _serial;  /**< Underlying serial port */
+    TxSlot _txPool[WINDOW];        /**< Unacknowledged outgoing messages */
+    RxSlot _rxPool[WINDOW];        /**< Received messages awaiting delivery */
+
+    uint8_t _txBase;               /**< Oldest unacknowledged sequence */
+    uint8_t _txNext;               /**< Sequence of the next send() */
+    uint8_t _rxNext;               /**< Next sequence handed to receive() */
+    bool _rxSynced;                /**< A SYN has fixed _rxNext */
+    bool _rxSynPhase;              /**< Peer still sends SYN (no plain data frame seen yet) */
+    bool _synPending;              /**< Outgoing data still carries SYN */
+    bool _ackPending;              /**< An ACK is owed to the peer */
+    uint32_t _ackDue;              /**< HAL tick at which a pure ACK is sent */
+    bool _linkUp;                  /**< See isLinkUp() */
+
+    uint32_t _srtt;                /**< Smoothed RTT in ms, scaled by 8 */
+    uint32_t _rttvar;              /**< RTT variation in ms, scaled by 4 */
+    uint32_t _rtoBase;             /**< Retransmit timeout from the RTT estimate */
+    uint32_t _rto;                 /**< _rtoBase with back-off applied */
+
+    uint8_t _rxFrame[MAX_RAW];     /**< Frame being unstuffed */
+    HdlcDecoder _rxDecoder;        /**< Unstuffs received bytes into _rxFrame */
+
+    uint8_t _txFrame[2 * MAX_RAW + 2]; /**< Stuffed frame being queued */
+
+    Stats _stats;                  /**< Counters */
+
+    /** @brief Validate and dispatch an unstuffed frame. */
+    void _handleFrame(const uint8_t* frame, uint16_t len);
+
+    /** @brief Apply the peer's ack / sack to the TX window. */
+    void _handleAck(uint8_t ack, uint32_t sack);
+
+    /** @brief Store a received data frame in the RX window. */
+    void _handleData(uint8_t seq, const uint8_t* payload, uint16_t len);
+
+    /** @brief Feed one RTT sample into SRTT / RTTVAR / RTO. */
+    void _rttSample(uint32_t rtt);
+
+    /** @brief Cumulative ack and SACK bitmap describing the RX window. */
+    uint8_t _ackState(uint32_t& sack) const;
+
+    /**
+     * @brief Stuff and queue one frame.
+     * @param slot TX slot whose payload is sent, or nullptr for a pure ACK.
+     * @param seq Sequence number of @p slot.
+     * @return false if it did not fit into the TX lane (nothing queued).
+     */
+    bool _sendFrame(const TxSlot* slot, uint8_t seq);
+};
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file Crc16.hpp
+ * @brief Table-driven CRC-16 (Modbus / IBM, polynomial 0xA001 reflected).
+ *
+ * Shared by the protocol layers built on top of STM32BufferedSerial.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_CRC16_HPP
+#define STM32_BUFFERED_SERIAL_CRC16_HPP
+
+#include <cstdint>
+
+/**
+ * @brief Compute CRC-16/MODBUS over a buffer.
+ * @param data Pointer to data.
+ * @param len Number of bytes.
+ * @param crc Initial value (0xFFFF for a new message, or a previous result to continue).
+ * @return CRC value. Transmitted low byte first in Modbus frames.
+ */
+uint16_t crc16Modbus(const uint8_t* data, uint16_t len, uint16_t crc = 0xFFFF);
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file Hdlc.hpp
+ * @brief HDLC-style byte stuffing (0x7E delimits, 0x7D escapes).
+ *
+ * Shared by the frame-based layers built on top of STM32BufferedSerial
+ * (ArqLink, SerialMux). A frame on the wire is 0x7E | stuffed bytes | 0x7E;
+ * a 0x7E or 0x7D inside the frame is sent as 0x7D followed by the byte XOR 0x20.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_HDLC_HPP
+#define STM32_BUFFERED_SERIAL_HDLC_HPP
+
+#include <cstdint>
+
+constexpr uint8_t HDLC_FLAG = 0x7E;    /**< Frame delimiter */
+constexpr uint8_t HDLC_ESC = 0x7D;     /**< Escape byte */
+constexpr uint8_t HDLC_ESC_XOR = 0x20; /**< XORed into an escaped byte */
+
+/**
+ * @brief Append @p len bytes to @p dst with byte stuffing.
+ * @param dst Destination buffer (room for 2 * @p len bytes after @p pos).
+ * @param pos Write position in @p dst.
+ * @param src Bytes to stuff.
+ * @param len Number of bytes.
+ * @return New write position.
+ */
+uint16_t hdlcStuff(uint8_t* dst, uint16_t pos, const uint8_t* src, uint16_t len);
+
+/**
+ * @class HdlcDecoder
+ * @brief Byte-at-a-time unstuffer into a caller-provided frame buffer.
+ */
+class HdlcDecoder {
+public:
+    /** @brief Result of feed(). */
+    enum Result : uint8_t {
+        NONE,   /**< Byte consumed, no frame boundary */
+        FRAME,  /**< A non-empty frame ended: see frame() / length() */
+        ERROR,  /**< A frame ended that was too long or ended in an escape */
+    };
+
+    /**
+     * @brief Construct the decoder.
+     * @param buf Frame buffer.
+     * @param size Size of @p buf; longer frames are dropped (ERROR).
+     */
+    HdlcDecoder(uint8_t* buf, uint16_t size) : _buf(buf), _size(size), _len(0), _frameLen(0),
+                                               _escape(false), _overrun(false) {}
+
+    /** @brief Drop the frame in progress. */
+    void reset() { _len = 0; _escape = false; _overrun = false; }
+
+    /** @brief Process one received byte. */
+    Result feed(uint8_t b)
+    {
+        if (b == HDLC_FLAG) {
+            Result r = (_overrun || _escape) ? ERROR : (_len ? FRAME : NONE);
+            _frameLen = _len;
+            reset();
+            return r;
+        }
+        if (_overrun) return NONE;   // skip to the next flag
+        if (b == HDLC_ESC) {
+            _escape = true;
+            return NONE;
+        }
+        if (_escape) {
+            b ^= HDLC_ESC_XOR;
+            _escape = false;
+        }
+        if (_len < _size) _buf[_len++] = b;
+        else _overrun = true;
+        return NONE;
+    }
+
+    /** @brief Unstuffed frame after feed() returned FRAME (valid until the next feed()). */
+    const uint8_t* frame() const { return _buf; }
+
+    /** @brief Length of frame(). */
+    uint16_t length() const { return _frameLen; }
+
+private:
+    uint8_t* _buf;       /**< Frame buffer */
+    uint16_t _size;      /**< Size of _buf */
+    uint16_t _len;       /**< Bytes of the frame in progress */
+    uint16_t _frameLen;  /**< Length of the last completed frame */
+    bool _escape;        /**< Previous byte was HDLC_ESC */
+    bool _overrun;       /**< Frame too long; skip to the next flag */
+};
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file ModbusRtu.hpp
+ * @brief Modbus RTU master / slave engine on top of STM32BufferedSerial.
+ *
+ * Frame boundaries are taken from the idle-line detection of
+ * STM32BufferedSerial (receiver timeout where available, IDLE otherwise)
+ * and read with readFrame(), so no inter-character timing has to be
+ * measured in software.
+ *
+ * Supported function codes:
+ * - 0x03 Read Holding Registers
+ * - 0x04 Read Input Registers
+ * - 0x06 Write Single Register
+ * - 0x10 Write Multiple Registers
+ *
+ * Typical slave usage:
+ * @code
+ * uint16_t regs[32];
+ * ModbusRtu modbus(serial);
+ * modbus.begin();
+ * modbus.setSlave(0x11, regs, 32);
+ *
+ * while (1) {
+ *     modbus.poll();
+ * }
+ * @endcode
+ *
+ * @note Call serial.handleIrq() from the USARTx_IRQHandler so idle events are seen.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_MODBUS_RTU_HPP
+#define STM32_BUFFERED_SERIAL_MODBUS_RTU_HPP
+
+#include "STM32BufferedSerial.hpp"
+#include <cstdint>
+
+/**
+ * @class ModbusRtu
+ * @brief Non-blocking Modbus RTU master and slave.
+ */
+class ModbusRtu {
+public:
+    static constexpr uint16_t MAX_FRAME = 256; /**< Maximum RTU frame size */
+
+    /** @brief State of the last master request. */
+    enum class Status : uint8_t {
+        Idle,       /**< No request issued */
+        Pending,    /**< Waiting for the response */
+        Ok,         /**< Valid response received */
+        Timeout,    /**< No response within the timeout */
+        CrcError,   /**< Response received with bad CRC */
+        Exception,  /**< Slave replied with an exception (see exceptionCode()) */
+        BadResponse /**< Response did not match the request */
+    };
+
+    /**
+     * @brief Construct a Modbus RTU engine.
+     * @param serial Serial port used for the bus.
+     */
+    explicit ModbusRtu(STM32BufferedSerial& serial);
+
+    /** @brief Enable 3.5-character frame detection on the serial port. */
+    void begin();
+
+    /**
+     * @brief Serve a register map as a slave.
+     * @param address Slave address (1-247).
+     * @param holding Holding registers (read/write), may be nullptr.
+     * @param holdingCount Number of holding registers.
+     * @param input Input registers (read only), may be nullptr.
+     * @param inputCount Number of input registers.
+     */
+    void setSlave(uint8_t address, uint16_t* holding, uint16_t holdingCount,
+                  const uint16_t* input = nullptr, uint16_t inputCount = 0);
+
+    /** @brief Process received frames and master timeouts. Call from the main loop. */
+    void poll();
+
+    /** @brief Master: request holding registers into @p dst. @return false if a request is pending or the frame did not fit in the TX buffer. */
+    bool readHoldingRegisters(uint8_t slave, uint16_t addr, uint16_t count,
+                              uint16_t* dst, uint32_t timeoutMs = 100);
+
+    /** @brief Master: request input registers into @p dst. @return false if a request is pending or the frame did not fit in the TX buffer. */
+    bool readInputRegisters(uint8_t slave, uint16_t addr, uint16_t count,
+                            uint16_t* dst, uint32_t timeoutMs = 100);
+
+    /** @brief Master: write one holding register. @return false if a request is pending or the frame did not fit in the TX buffer. */
+    bool writeSingleRegister(uint8_t slave, uint16_t addr, uint16_t value,
+                             uint32_t timeoutMs = 100);
+
+    /** @brief Master: write consecutive holding registers. @return false if a request is pending or the frame did not fit in the TX buffer. */
+    bool writeMultipleRegisters(uint8_t slave, uint16_t addr, const uint16_t* src,
+                                uint16_t count, uint32_t timeoutMs = 100);
+
+    /** @brief State of the last master request. */
+    Status status() const { return _status; }
+
+    /** @brief Exception code of the last response (valid when status() == Exception). */
+    uint8_t exceptionCode() const { return _exception; }
+
+    /** @brief Number of frames dropped because of a CRC mismatch. */
+    uint32_t getCrcErrors() const { return _crcErrors; }
+
+    /** @brief Number of frames not sent because the TX buffer could not take the whole frame. */
+    uint32_t getTxErrors() const { return _txErrors; }
+
+private:
+    STM32BufferedSerial& _serial;  /**< Underlying serial port */
+    uint8_t _frame[MAX_FRAME];     /**< Received frame */
+
+    uint8_t _slaveAddr;            /**< Own address (0 = slave disabled) */
+    uint16_t* _holding;            /**< Holding registers */
+    uint16_t _holdingCount;        /**< Number of holding registers */
+    const uint16_t* _input;        /**< Input registers */
+    uint16_t _inputCount;          /**< Number of input registers */
+
+    Status _status;                /**< Master request state */
+    uint8_t _exception;            /**< Last exception code */
+    uint8_t _reqSlave;             /**< Addressed slave */
+    uint8_t _reqFunction;          /**< Requested function code */
+    uint16_t _reqAddr;             /**< Requested start register */
+    uint16_t _reqCount;            /**< Requested register count */
+    uint16_t* _reqDst;             /**< Destination for read responses */
+    uint32_t _reqStart;            /**< HAL tick when the request was sent */
+    uint32_t _reqTimeout;          /**< Response timeout in ms */
+    uint32_t _crcErrors;           /**< Frames with bad CRC */
+    uint32_t _txErrors;            /**< Frames that did not fit in the TX buffer */
+
+    /** @brief Validate and dispatch a complete frame. */
+    void _handleFrame(const uint8_t* frame, uint16_t len);
+
+    /** @brief Serve a request addressed to this slave. */
+    void _serveRequest(const uint8_t* frame, uint16_t len);
+
+    /** @brief Match a response to the pending master request. */
+    void _handleResponse(const uint8_t* frame, uint16_t len);
+
+    /** @brief Send an exception response. */
+    void _sendException(uint8_t function, uint8_t code);
+
+    /** @brief Append CRC and queue the whole frame for transmission. @return false if it did not fit. */
+    bool _sendFrame(const uint8_t* frame, uint16_t len);
+
+    /** @brief Common part of the register read requests. */
+    bool _requestRead(uint8_t function, uint8_t slave, uint16_t addr, uint16_t count,
+                      uint16_t* dst, uint32_t timeoutMs);
+};
+
+#endif
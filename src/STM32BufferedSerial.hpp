@@ -12,6 +12,7 @@
  * - Supports multiple UART instances (up to 6 by default).
  * - Designed to work with standard HAL UART interrupt callbacks.
  * - Automatically restarts reception to handle HAL busy states safely.
+ * - Recovers from overrun / framing / noise / parity errors and counts them.
  *
  * Typical usage:
  * @code
@@ -39,6 +40,11 @@
  *     if (auto inst = STM32BufferedSerial::fromHandle(huart))
  *         inst->handleTxComplete();
  * }
+ *
+ * void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
+ *     if (auto inst = STM32BufferedSerial::fromHandle(huart))
+ *         inst->handleError();
+ * }
  * @endcode
  *
  * @see HAL_UART_Receive_IT()
@@ -53,7 +59,50 @@
 #define STM32_BUFFERED_SERIAL_HPP
 
 #include "stm32f4xx_hal.h"
+#include <cstdarg>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @name RX overflow policies
+ * Select one at compile time by defining STM32BS_RX_OVERFLOW_POLICY
+ * (e.g. `-DSTM32BS_RX_OVERFLOW_POLICY=STM32BS_RX_OVERWRITE_OLDEST`).
+ * @{
+ */
+#define STM32BS_RX_DROP_NEWEST      0  /**< Discard the incoming byte when the RX ring is full (default) */
+#define STM32BS_RX_OVERWRITE_OLDEST 1  /**< Discard the oldest unread byte to keep the latest data */
+#define STM32BS_RX_THROTTLE         2  /**< Deassert RTS / send XOFF before the ring fills to pause the sender */
+/** @} */
+
+#ifndef STM32BS_RX_OVERFLOW_POLICY
+#define STM32BS_RX_OVERFLOW_POLICY STM32BS_RX_DROP_NEWEST
+#endif
+
+#ifndef STM32BS_RX_FRAME_QUEUE
+/** Number of frame-end markers (idle events) kept for readFrame(). */
+#define STM32BS_RX_FRAME_QUEUE 8
+#endif
+
+#ifndef STM32BS_TX_MARKERS
+/** Frame boundaries / completion callbacks tracked per TX lane. */
+#define STM32BS_TX_MARKERS 8
+#endif
+
+#ifndef STM32BS_TX_LANES
+/** Number of TX queues (lane 0 is used by write(); higher lanes are more urgent). */
+#define STM32BS_TX_LANES 2
+#endif
+
+#ifndef STM32BS_TX_LANE_SIZE
+/** Ring size of the TX lanes other than lane 0. */
+#define STM32BS_TX_LANE_SIZE 64
+#endif
+
+#ifndef STM32BS_RX_THROTTLE_MARGIN
+/** Default free bytes left in the RX ring when STM32BS_RX_THROTTLE pauses the sender. */
+#define STM32BS_RX_THROTTLE_MARGIN 16
+#endif
 
 /**
  * @class STM32BufferedSerial
@@ -61,10 +110,73 @@
  */
 class STM32BufferedSerial {
 public:
+    /** @brief Outcome of autoBaud(). */
+    struct AutoBaudResult {
+        bool ok;               /**< A rate was detected and the UART configured */
+        uint32_t measured;     /**< Measured rate [baud] (with auto-baud hardware, the rate the UART runs at) */
+        uint32_t baud;         /**< Nearest standard rate within 3 % (else measured); the UART runs at it on F4 */
+        float errorPercent;    /**< (measured - baud) / baud * 100 */
+    };
+
+    /** @brief RS-485 half-duplex settings (see enableRs485()). */
+    struct Rs485Config {
+        GPIO_TypeDef* dePort;   /**< DE GPIO port, or nullptr to use the USART hardware DE signal */
+        uint16_t dePin;         /**< DE GPIO pin mask (active high) */
+        uint8_t assertTime;     /**< DE assertion to start bit, in sample times (1/16 or 1/8 bit, 0-31) */
+        uint8_t deassertTime;   /**< End of stop bit to DE release, in sample times (0-31) */
+        bool echoSuppress;      /**< Disable the receiver while driving the bus */
+    };
+
+    /** @brief Event flags passed to EventCallback (combine with |). */
+    enum Event : uint32_t {
+        EVENT_RX_DATA      = 1u << 0,  /**< Any byte stored in the RX buffer */
+        EVENT_RX_COUNT     = 1u << 1,  /**< RX fill level reached setEventCount() */
+        EVENT_RX_DELIMITER = 1u << 2,  /**< setEventDelimiter() byte received */
+        EVENT_RX_IDLE      = 1u << 3,  /**< Idle line / receiver timeout (see enableIdleDetection()) */
+        EVENT_RX_WATERMARK = 1u << 4,  /**< RX fill level reached the high watermark */
+        EVENT_TX_DONE      = 1u << 5,  /**< A TX chunk finished (buffer space was freed) */
+    };
+
+    /**
+     * @brief Notification hook.
+     * @param serial Instance that raised the events.
+     * @param events Bitwise OR of Event flags.
+     * @param context User pointer given to setEventCallback().
+     */
+    using EventCallback = void (*)(STM32BufferedSerial& serial, uint32_t events, void* context);
+
+    /**
+     * @brief Message transmit-complete callback (called from the TX complete interrupt).
+     * @param serial Instance that sent the message.
+     * @param context User pointer given to write().
+     */
+    using TxDoneCallback = void (*)(STM32BufferedSerial& serial, void* context);
+
+    /** @brief One segment of a gathered write (see writev()). */
+    struct IoVec {
+        const uint8_t* data;  /**< Segment start */
+        uint16_t len;         /**< Segment length */
+    };
+
+    /** @brief How the TX engine chooses between lanes at frame boundaries. */
+    enum TxScheduling : uint8_t {
+        TX_SCHED_STRICT,    /**< Always serve the highest non-empty lane (default) */
+        TX_SCHED_WEIGHTED,  /**< Deficit round robin using setTxLaneWeight() */
+    };
+
+    /** @brief Per-type UART error counters (see handleError()). */
+    struct ErrorCounters {
+        uint32_t overrun;   /**< ORE: a byte arrived before the previous one was read */
+        uint32_t framing;   /**< FE: stop bit not detected */
+        uint32_t noise;     /**< NE: noise detected while sampling */
+        uint32_t parity;    /**< PE: parity mismatch */
+    };
+
     /**
      * @brief Construct a new STM32BufferedSerial object.
      * @param huart Pointer to HAL UART handle (e.g., &huart2)
-     * @param bufSize Size of both TX and RX buffers (default: 256 bytes)
+     * @param bufSize Size of both TX and RX buffers (default: 256 bytes).
+     *                The RX buffer is rounded up to a power of two.
      */
     explicit STM32BufferedSerial(UART_HandleTypeDef* huart, uint16_t bufSize = 256);
 
@@ -76,6 +188,96 @@ public:
      */
     int read();
 
+    /** @brief Get a buffered byte without removing it from the RX buffer.
+     *  @param offset Position from the read position (0 = next byte read() would return).
+     *  @return Byte (0–255), or -1 if fewer than @p offset + 1 bytes are buffered.
+     */
+    int peek(uint16_t offset = 0) const;
+
+    /**
+     * @brief Read-only random-access view of the buffered RX bytes.
+     *
+     * The view covers the bytes that were readable when it was created; indexing
+     * and iteration hide the ring wrap and cost one masked load per byte. It is
+     * invalidated by read() / rxConsume() / flushRx() (and, with
+     * STM32BS_RX_OVERWRITE_OLDEST, by the ring overflowing).
+     * @code
+     * auto v = serial.peekView();
+     * if (v.size() >= 2 && v.size() >= 2u + v[1]) {   // [type][len][payload...]
+     *     uint8_t frame[64];
+     *     serial.read(frame, 2 + v[1]);
+     * }
+     * @endcode
+     */
+    class PeekView {
+    public:
+        /** @brief Forward iterator over the view. */
+        class iterator {
+        public:
+            uint8_t operator*() const { return _view->operator[](_pos); }
+            iterator& operator++() { _pos++; return *this; }
+            bool operator==(const iterator& o) const { return _pos == o._pos; }
+            bool operator!=(const iterator& o) const { return _pos != o._pos; }
+        private:
+            friend class PeekView;
+            iterator(const PeekView* view, uint16_t pos) : _view(view), _pos(pos) {}
+            const PeekView* _view;
+            uint16_t _pos;
+        };
+
+        /** @brief Number of bytes in the view. */
+        uint16_t size() const { return _len; }
+        bool empty() const { return _len == 0; }
+
+        /** @brief Byte at @p i (0 = next byte read() would return; not range-checked). */
+        uint8_t operator[](uint16_t i) const { return _buf[(_start + i) & _mask]; }
+
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, _len); }
+
+    private:
+        friend class STM32BufferedSerial;
+        PeekView(const uint8_t* buf, uint16_t mask, uint16_t start, uint16_t len)
+            : _buf(buf), _mask(mask), _start(start), _len(len) {}
+        const uint8_t* _buf;
+        uint16_t _mask;
+        uint16_t _start;
+        uint16_t _len;
+    };
+
+    /** @brief Create a view of the currently buffered RX bytes (nothing is consumed). */
+    PeekView peekView() const;
+
+    /** @brief Read multiple bytes from RX buffer.
+     *  @param dst Destination buffer.
+     *  @param len Maximum number of bytes to read.
+     *  @return Number of bytes copied (0 if no data available).
+     */
+    int read(uint8_t* dst, uint16_t len);
+
+    /** @brief Get the readable bytes that are contiguous in the RX ring, without consuming them.
+     *  Use with rxConsume() to parse in place. With STM32BS_RX_OVERWRITE_OLDEST the
+     *  region may be overwritten by new data if the ring fills up before rxConsume().
+     *  @param len Receives the region length (0 if no data).
+     *  @return Start of the region.
+     */
+    const uint8_t* rxPeekContiguous(uint16_t& len) const;
+
+    /** @brief Discard @p len bytes from the RX ring (clamped to readable_len()). */
+    void rxConsume(uint16_t len);
+
+    /** @brief Read one complete burst terminated by an idle-line event.
+     *  Requires enableIdleDetection(). If the burst is longer than @p max, the
+     *  first @p max bytes are copied and the remainder is discarded.
+     *  @param dst Destination buffer.
+     *  @param max Size of @p dst.
+     *  @return Length of the burst (may exceed @p max), or 0 if no complete burst is buffered.
+     */
+    int readFrame(uint8_t* dst, uint16_t max);
+
+    /** @brief Length of the next complete burst, or 0 if none is buffered. */
+    int nextFrameLength() const;
+
     /** @brief Write a single byte to TX buffer and start interrupt-driven transmission.
      *  @param data Byte to send.
      *  @return 1 if success, -1 if TX buffer is full.
@@ -89,6 +291,144 @@ public:
      */
     int write(const uint8_t* data, uint16_t len);
 
+    /** @brief Write a message and get notified when its last byte has been sent.
+     *  The message is queued completely or not at all. @p done is called from
+     *  handleTxComplete() once the last byte has left the shift register
+     *  (transmission is split at message ends so the notification is exact).
+     *  Callbacks of messages discarded by flushTx() are not called.
+     *  @param data Pointer to data buffer.
+     *  @param len Number of bytes to send.
+     *  @param done Completion callback.
+     *  @param context User pointer passed to @p done.
+     *  @return @p len if queued, 0 if there is not enough buffer space or
+     *          STM32BS_TX_MARKERS markers are already outstanding.
+     */
+    int write(const uint8_t* data, uint16_t len, TxDoneCallback done, void* context = nullptr);
+
+    /** @brief Reserve the contiguous free space at the write position of lane 0 for writing in place.
+     *  Until txCommit() is called, other lane-0 writes (and printf()) fail as if the ring were full,
+     *  so keep the reservation short.
+     *  @param len Receives the region length.
+     *  @return Start of the region, or nullptr if there is no space or a reservation / printf() is in progress.
+     */
+    uint8_t* txReserve(uint16_t& len);
+
+    /** @brief Queue the first @p len bytes of the reserved region and release the reservation (0 to cancel). */
+    void txCommit(uint16_t len);
+
+    /** @brief Write a frame to a specific TX lane.
+     *  Each call is one frame: the TX engine only switches lanes between frames,
+     *  so frames of different lanes are never interleaved on the wire.
+     *  @param lane Lane index (0 = lane used by write(); higher = more urgent with TX_SCHED_STRICT).
+     *  @param data Pointer to data buffer.
+     *  @param len Number of bytes to send.
+     *  @param done Optional completion callback (the frame is then queued all-or-nothing).
+     *  @param context User pointer passed to @p done.
+     *  @return Number of bytes queued.
+     */
+    int writeLane(uint8_t lane, const uint8_t* data, uint16_t len,
+                  TxDoneCallback done = nullptr, void* context = nullptr);
+
+    /** @brief Write several segments as one frame without concatenating them first.
+     *  The segments are copied into the lane in order under one lock, so they are
+     *  never interleaved with other writers. Nothing is queued unless all fit.
+     *  @param iov Segment array.
+     *  @param count Number of segments.
+     *  @param lane TX lane (see writeLane()).
+     *  @param done Optional completion callback for the whole frame.
+     *  @param context User pointer passed to @p done.
+     *  @return Total number of bytes queued, or 0 if they did not fit.
+     */
+    int writev(const IoVec* iov, uint8_t count, uint8_t lane = 0,
+               TxDoneCallback done = nullptr, void* context = nullptr);
+
+    /** @brief Transmit a caller-owned buffer without copying it into the TX ring.
+     *  The buffer is sent in order after everything already written to lane 0 and
+     *  before anything written afterwards. With a TX DMA channel linked to the UART
+     *  handle (hdmatx) it is sent by DMA in chunks of up to 65535 bytes, otherwise
+     *  by interrupt. Flash is fine as a source; CCM RAM is not reachable by DMA.
+     *  @param data Buffer to send. It must stay valid and unchanged until @p done is called.
+     *  @param len Number of bytes (may exceed 64 KiB).
+     *  @param done Optional completion callback.
+     *  @param context User pointer passed to @p done.
+     *  @return false if @p len is 0 or STM32BS_TX_MARKERS markers are already outstanding.
+     */
+    bool sendBuffer(const uint8_t* data, uint32_t len, TxDoneCallback done = nullptr, void* context = nullptr);
+
+    /** @brief Formatted output rendered directly into the TX ring (no heap, no temporary buffer).
+     *  Supports %d %i %u %x %X %o %c %s %p %% and %f (%e / %g are printed as %f) with the
+     *  flags - 0 + space, width, precision, '*' and the hh h l ll z j t length modifiers
+     *  (%f rounds half up, at most 9 fraction digits).
+     *  Output that does not fit into lane 0 is truncated. Not for use from interrupt
+     *  handlers; lane-0 writes from an ISR fail (return 0) while a call is formatting.
+     *  @return Number of bytes queued.
+     */
+    int printf(const char* fmt, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 2, 3)))
+#endif
+        ;
+
+    /** @brief va_list version of printf(). */
+    int vprintf(const char* fmt, va_list args);
+
+    /** @brief Print a string. @return Number of bytes queued. */
+    int print(const char* s);
+    /** @brief Print a signed integer in decimal. */
+    int print(int v);
+    /** @brief Print a signed integer in decimal. */
+    int print(long v);
+    /** @brief Print an unsigned integer in base 10 or 16. */
+    int print(unsigned int v, uint8_t base = 10);
+    /** @brief Print an unsigned integer in base 10 or 16. */
+    int print(unsigned long v, uint8_t base = 10);
+    /** @brief Print a floating point value with @p digits fraction digits. */
+    int print(double v, uint8_t digits = 2);
+
+    /** @brief Print a fixed-point value (@p v / 10^@p fracDigits), e.g. printFixed(-1234, 2) -> "-12.34". */
+    int printFixed(int32_t v, uint8_t fracDigits);
+
+    /** @brief Print a string followed by "\r\n". */
+    int println(const char* s = "");
+
+    static constexpr uint8_t LOG_SYNC = 0xA5;  /**< First byte of every binary log record */
+
+    /** @brief Queue one binary log record (use the STM32BS_LOG() macro instead of calling this).
+     *  Record layout: LOG_SYNC, length byte (bytes up to the CRC), 16-bit little-endian
+     *  string ID (low 16 bits of the format string address), the arguments in order,
+     *  then a little-endian CRC-16/MODBUS over the length byte, ID and arguments.
+     *  Integers and pointers take 4 bytes (8 for 64-bit types), floating point a
+     *  4-byte float, strings a length byte plus up to 255 characters.
+     *  A record that does not fit into lane 0 is dropped whole.
+     *  @return Number of bytes queued (0 if dropped).
+     */
+    template <typename... Args>
+    int logRecord(const char* fmt, Args... args) {
+        uint32_t len = 2 + _logSize(args...);
+        if (len > 255) return 0;
+        TxStage st;
+        if (!_stageBegin(st)) return 0;
+        if (st.left >= len + 4) {
+            uintptr_t id = reinterpret_cast<uintptr_t>(fmt);
+            st.put(static_cast<char>(LOG_SYNC));
+            st.put(static_cast<char>(len));
+            st.put(static_cast<char>(id & 0xFF));
+            st.put(static_cast<char>((id >> 8) & 0xFF));
+            _logPut(st, args...);
+            _logSeal(st);
+        }
+        return _stageCommit(st);
+    }
+
+    /** @brief Select strict-priority or weighted (deficit round robin) lane scheduling. */
+    void setTxScheduling(TxScheduling mode);
+
+    /** @brief Set the DRR quantum of a lane in bytes (TX_SCHED_WEIGHTED, default 64). */
+    void setTxLaneWeight(uint8_t lane, uint16_t weight);
+
+    /** @brief Get number of bytes that can currently be queued into a TX lane. */
+    int writable_len(uint8_t lane = 0) const;
+
     /** @brief Check if RX buffer contains data.
      *  @return true if data available.
      */
@@ -99,12 +439,79 @@ public:
      */
     int readable_len() const;
 
-    /** @brief Clear RX buffer. */
+    /** @brief Maximum number of bytes the RX buffer can hold. */
+    int rxCapacity() const { return _rxSize - 1; }
+
+    /** @brief Highest RX fill level a sender that keeps sending is guaranteed to reach.
+     *  rxCapacity(), or the high watermark with STM32BS_RX_THROTTLE (the sender is paused there).
+     *  Use it to cap setEventCount() so EVENT_RX_COUNT can fire.
+     */
+    int rxFillLimit() const {
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_THROTTLE
+        return _rxHighWater;
+#else
+        return rxCapacity();
+#endif
+    }
+
+    /** @brief Clear RX buffer. Safe against concurrent RX interrupts. */
     void flushRx();
 
-    /** @brief Clear TX buffer. */
+    /** @brief Discard pending TX data.
+     *  A transfer in progress is aborted after the byte currently in the shift register.
+     *  Pending XON/XOFF bytes are kept.
+     */
     void flushTx();
 
+    /** @brief Wait until all queued TX data has physically left the UART.
+     *  Returns when the TX buffer is empty and the transmission-complete (TC) flag is set
+     *  (and, in RS-485 mode, the bus has been released). Do not call from an interrupt.
+     *  @param timeoutMs Timeout in ms (HAL_MAX_DELAY to wait forever).
+     *  @param sleep Sleep in WFI while waiting instead of spinning.
+     *  @return true if drained, false on timeout.
+     */
+    bool drain(uint32_t timeoutMs = HAL_MAX_DELAY, bool sleep = false);
+
+    /** @brief Check whether TX is completely idle (buffer empty and TC set). */
+    bool isTxIdle() const;
+
+    /** @brief Change the baud rate at run time, keeping buffered RX data.
+     *  Switches to 8x oversampling when 16x cannot reach @p baud with the current PCLK.
+     *  @param baud New baud rate.
+     *  @param timeoutMs Time allowed for queued TX data to drain first.
+     *  @return false if TX did not drain in time or HAL_UART_Init() failed (settings unchanged on timeout).
+     */
+    bool setBaud(uint32_t baud, uint32_t timeoutMs = 100);
+
+    /** @brief Re-initialize the UART with new settings, keeping buffered RX data.
+     *  Drains TX, stops reception, calls HAL_UART_Init() (HAL_RS485Ex_Init() for hardware DE),
+     *  restores idle detection, then re-arms reception.
+     *  @param init New word length / parity / stop bits / baud rate / oversampling / flow control.
+     *  @param timeoutMs Time allowed for queued TX data to drain first.
+     *  @return false if TX did not drain in time or the HAL init failed.
+     */
+    bool reconfigure(const UART_InitTypeDef& init, uint32_t timeoutMs = 100);
+
+    /** @brief Detect the baud rate from the first received frame, configure the UART and start reception.
+     *  - Parts with auto-baud hardware (USART_CR2_ABREN): the USART measures the start bit and the
+     *    first byte is received normally. BRR keeps the measured value and Init.BaudRate is set to
+     *    @c measured, so a later setBaud() / reconfigure() does not restart detection.
+     *  - Other parts (F4): the RX pin is polled with the DWT cycle counter. Interrupts stay enabled
+     *    while waiting for the start bit and are masked only for the capture of one frame, at most
+     *    10 bit times at 300 baud (33 ms); a line held low (BREAK) longer than that fails. The bit
+     *    time is averaged over all edges of that frame, which is decoded (8 data bits) and stored in
+     *    the RX buffer; the UART is then set to the nearest standard rate within 3 % (or the measured
+     *    rate). If an interrupt delays detection of the start edge, that frame is discarded and the
+     *    next one is measured. The first byte needs a single-bit pulse (e.g. 'U' or '\r') and the
+     *    sender should pause for one character time after it.
+     *  The USART kernel clock is assumed to be its APB clock.
+     *  @param rxPort GPIO port of the RX pin (edge timing only).
+     *  @param rxPin GPIO pin of the RX pin (edge timing only).
+     *  @param timeoutMs Time to wait for the first frame.
+     *  @return Detection result; ok is false on timeout or if the measurement failed.
+     */
+    AutoBaudResult autoBaud(GPIO_TypeDef* rxPort, uint16_t rxPin, uint32_t timeoutMs = 1000);
+
     /** @brief Handle RX complete interrupt.
      *  Should be called from HAL_UART_RxCpltCallback().
      */
@@ -115,6 +522,137 @@ public:
      */
     void handleTxComplete();
 
+    /** @brief Handle UART error interrupt (ORE/FE/NE/PE).
+     *  Should be called from HAL_UART_ErrorCallback().
+     *  Counts the error, clears the flags and re-arms reception if HAL aborted it.
+     */
+    void handleError();
+
+    /** @brief Get a snapshot of the error counters. */
+    ErrorCounters getErrorCounters() const { return _errors; }
+
+    /** @brief Reset all error counters to zero. */
+    void clearErrorCounters();
+
+    /** @brief Insert a marker byte into the RX stream at the position of each error.
+     *  @param enable true to insert markers, false to disable (default).
+     *  @param marker Byte value to insert.
+     */
+    void setErrorMarker(bool enable, uint8_t marker = 0xFF);
+
+    /** @brief Get number of received bytes lost because the RX buffer was full.
+     *  With STM32BS_RX_OVERWRITE_OLDEST this counts overwritten (oldest) bytes.
+     */
+    uint32_t getRxDropped() const { return _rxDropped; }
+
+    /** @brief Set the GPIO used as RTS output (active low).
+     *  Used by STM32BS_RX_THROTTLE to pause the sender before the RX buffer fills.
+     *  Not needed when the UART is initialised with hardware RTS
+     *  (UART_HWCONTROL_RTS): reception is then simply not re-armed above the
+     *  high watermark and the peripheral deasserts RTS by itself.
+     *  @param port GPIO port (nullptr to disable).
+     *  @param pin GPIO pin mask (e.g. GPIO_PIN_1).
+     */
+    void setRtsPin(GPIO_TypeDef* port, uint16_t pin);
+
+    /** @brief Set the RX fill levels used by STM32BS_RX_THROTTLE.
+     *  @param high Pause the sender when this many bytes are buffered.
+     *  @param low Resume the sender when the fill level drops to this value.
+     */
+    void setRxWatermarks(uint16_t high, uint16_t low);
+
+    /** @brief Set the GPIO used as CTS input (active low).
+     *  Transmission pauses while the pin is high. Call handleCtsChange() from the
+     *  pin's EXTI callback to resume. Not needed with hardware CTS (UART_HWCONTROL_CTS).
+     *  @param port GPIO port (nullptr to disable).
+     *  @param pin GPIO pin mask.
+     */
+    void setCtsPin(GPIO_TypeDef* port, uint16_t pin);
+
+    /** @brief Resume transmission after the CTS GPIO changed.
+     *  Should be called from HAL_GPIO_EXTI_Callback() for the CTS pin.
+     */
+    void handleCtsChange();
+
+    /** @brief Enable or disable software (XON/XOFF) flow control.
+     *  When enabled, received XON (0x11) / XOFF (0x13) bytes are removed from the
+     *  RX stream and resume / pause transmission immediately. With STM32BS_RX_THROTTLE,
+     *  XOFF / XON are also sent at the RX watermarks, ahead of queued TX data.
+     *  Binary data containing 0x11 / 0x13 cannot be used in this mode.
+     */
+    void setSoftwareFlowControl(bool enable);
+
+    /** @brief Check whether transmission is paused by a received XOFF. */
+    bool isTxPaused() const { return _txPaused; }
+
+    /** @brief Enable RS-485 half-duplex mode.
+     *  The driver enable (DE) is asserted before the first byte and released from
+     *  the TX complete (TC) interrupt once the TX buffer is empty. On USARTs with a
+     *  hardware DE signal (USART_CR3_DEM) HAL_RS485Ex_Init() is used and the
+     *  timings are applied by the peripheral; otherwise the GPIO is driven from the
+     *  ISR, timed with the DWT cycle counter. The guard times are busy-waited with
+     *  interrupts enabled.
+     *  @param cfg RS-485 settings.
+     *  @return false if cfg.dePort is nullptr on a USART without hardware DE.
+     */
+    bool enableRs485(const Rs485Config& cfg);
+
+    /** @brief Total time (ms) the remote sender has been paused by RTS / XOFF. */
+    uint32_t getRxStallMs() const;
+
+    /** @brief Total time (ms) transmission has waited for CTS. */
+    uint32_t getTxStallMs() const;
+
+    /** @brief Enable end-of-burst detection on the RX line.
+     *  Uses the USART receiver timeout (RTOF) when available and @p timeoutBits is
+     *  non-zero, otherwise the IDLE interrupt (one character of silence).
+     *  handleIrq() must be called from the USARTx_IRQHandler.
+     *  @param timeoutBits Silence length in bit times (e.g. 39 for 3.5 chars of 8N1+parity).
+     */
+    void enableIdleDetection(uint32_t timeoutBits = 0);
+
+    /** @brief Handle IDLE / receiver-timeout flags.
+     *  Call from USARTx_IRQHandler() before HAL_UART_IRQHandler(). When the interrupt
+     *  was delayed and the burst's last byte is still in DR, the frame end is recorded
+     *  after HAL_UART_IRQHandler() has stored that byte.
+     */
+    void handleIrq();
+
+    /** @brief Number of idle-line events seen since begin(). */
+    uint32_t getIdleCount() const { return _rxIdleCount; }
+
+    /** @brief Number of bursts merged with the previous one because the frame queue was full. */
+    uint32_t getFramesMerged() const { return _rxFramesMerged; }
+
+    /** @brief Install a notification hook.
+     *  By default the callback runs in the UART interrupt; see setEventDeferral().
+     *  @param cb Callback, or nullptr to disable.
+     *  @param context User pointer passed to the callback.
+     *  @param mask Events to report (Event flags).
+     */
+    void setEventCallback(EventCallback cb, void* context, uint32_t mask);
+
+    /** @brief Change the reported events without replacing the callback. */
+    void setEventMask(uint32_t mask) { _eventMask = _eventCb ? mask : 0; }
+
+    /** @brief Set the fill level that raises EVENT_RX_COUNT. */
+    void setEventCount(uint16_t count) { _eventCount = count; }
+
+    /** @brief Set the byte that raises EVENT_RX_DELIMITER (e.g. '\n'). */
+    void setEventDelimiter(uint8_t delimiter) { _eventDelimiter = delimiter; }
+
+    /** @brief Run the callback from a software-pended interrupt instead of the UART ISR.
+     *  Events are accumulated and the interrupt is pended (PendSV_IRQn sets PENDSVSET,
+     *  any other IRQ uses NVIC_SetPendingIRQ, e.g. an unused EXTI line). Call
+     *  dispatchEvents() from that interrupt handler.
+     *  @param enable true to defer, false to call from the UART ISR.
+     *  @param irq Interrupt to pend.
+     */
+    void setEventDeferral(bool enable, IRQn_Type irq = PendSV_IRQn);
+
+    /** @brief Deliver accumulated deferred events. Call from the deferral IRQ handler. */
+    void dispatchEvents();
+
     /** @brief Get internal UART handle. */
     UART_HandleTypeDef* getHandle() const { return _huart; }
 
@@ -135,14 +673,87 @@ public:
 private:
     UART_HandleTypeDef* _huart;   /**< HAL UART handle */
     uint8_t* _rxBuf;              /**< RX ring buffer */
-    uint8_t* _txBuf;              /**< TX ring buffer */
-    uint16_t _rxSize;             /**< RX buffer size */
-    uint16_t _txSize;             /**< TX buffer size */
+    uint16_t _rxSize;             /**< RX buffer size (power of two) */
+    uint16_t _rxMask;             /**< _rxSize - 1 */
     volatile uint16_t _rxHead;    /**< RX buffer write index */
     volatile uint16_t _rxTail;    /**< RX buffer read index */
-    volatile uint16_t _txHead;    /**< TX buffer write index */
-    volatile uint16_t _txTail;    /**< TX buffer read index */
     uint8_t _rxTmp;               /**< Temporary byte for interrupt reception */
+    ErrorCounters _errors;        /**< UART error statistics */
+    bool _errMarkerEnabled;       /**< Insert _errMarker into RX stream on error */
+    uint8_t _errMarker;           /**< Marker byte for corrupted positions */
+    volatile uint32_t _rxDropped; /**< Bytes lost to RX overflow */
+    GPIO_TypeDef* _rtsPort;       /**< RTS GPIO port (nullptr if unused) */
+    uint16_t _rtsPin;             /**< RTS GPIO pin mask */
+    volatile bool _rxThrottled;   /**< true while the sender is paused */
+    uint16_t _rxHighWater;        /**< Throttle when RX fill level reaches this */
+    uint16_t _rxLowWater;         /**< Release when RX fill level drops to this */
+    uint32_t _rxStallStart;       /**< HAL tick when throttling started */
+    volatile uint32_t _rxStallMs; /**< Accumulated RX throttle time */
+    GPIO_TypeDef* _ctsPort;       /**< CTS GPIO port (nullptr if unused) */
+    uint16_t _ctsPin;             /**< CTS GPIO pin mask */
+    volatile bool _txCtsStalled;  /**< true while TX waits for CTS */
+    uint32_t _txStallStart;       /**< HAL tick when CTS stall started */
+    volatile uint32_t _txStallMs; /**< Accumulated CTS stall time */
+    volatile bool _txBusy;        /**< true while a HAL transmit is in flight */
+    volatile uint16_t _txChunk;   /**< Bytes handed to HAL in the current transmit */
+
+    /** @brief Frame end in a TX lane, with optional completion callback. */
+    struct TxMarker {
+        uint32_t end;             /**< TxLane::sent value when the frame is complete */
+        TxDoneCallback cb;        /**< Callback (nullptr for a plain frame boundary) */
+        void* ctx;                /**< User pointer */
+        const uint8_t* ext;       /**< Caller buffer sent at @c end (sendBuffer()), or nullptr */
+        uint32_t extLen;          /**< Length of @c ext */
+    };
+
+    /** @brief One TX queue (ring buffer plus frame markers). */
+    struct TxLane {
+        uint8_t* buf;             /**< Ring buffer */
+        uint16_t size;            /**< Ring size */
+        volatile uint16_t head;   /**< Write index */
+        volatile uint16_t tail;   /**< Read index */
+        uint32_t queued;          /**< Total bytes queued */
+        volatile uint32_t sent;   /**< Total bytes transmitted */
+        uint32_t frameStart;      /**< sent value at the last frame boundary */
+        TxMarker markers[STM32BS_TX_MARKERS]; /**< Frame end queue */
+        volatile uint8_t markHead; /**< Marker write index */
+        volatile uint8_t markTail; /**< Marker read index */
+        uint16_t weight;          /**< DRR quantum in bytes */
+        int32_t deficit;          /**< DRR deficit counter */
+    };
+    TxLane _tx[STM32BS_TX_LANES]; /**< TX lanes */
+    volatile uint8_t _txCur;      /**< Lane of the in-flight / current frame */
+    TxScheduling _txSched;        /**< Lane scheduling mode */
+    uint8_t _txRr;                /**< DRR position */
+    volatile bool _txStaging;     /**< printf() is rendering into lane 0 */
+    bool _txExt;                  /**< In-flight chunk comes from a sendBuffer() buffer */
+    uint32_t _txExtOff;           /**< Bytes of the front sendBuffer() buffer already sent */
+    bool _xonxoff;                /**< Software flow control enabled */
+    volatile bool _txPaused;      /**< XOFF received from the peer */
+    volatile uint8_t _txCtrl;     /**< Pending XON/XOFF to send (0 if none) */
+    uint8_t _txCtrlByte;          /**< XON/XOFF byte being transmitted */
+
+    volatile uint32_t _rxIdleCount; /**< Idle-line events */
+    volatile uint32_t _rxCount;   /**< Total bytes stored into the RX ring */
+    uint32_t _rxFrameEnds[STM32BS_RX_FRAME_QUEUE]; /**< Frame ends as _rxCount values */
+    volatile uint8_t _rxFrameHead; /**< Frame queue write index (ISR) */
+    volatile uint8_t _rxFrameTail; /**< Frame queue read index */
+    volatile uint32_t _rxFramesMerged; /**< Bursts merged on frame queue overflow */
+    bool _rxIdlePending;          /**< IDLE seen while the last byte was still in DR */
+    EventCallback _eventCb;       /**< Notification hook */
+    void* _eventCtx;              /**< User pointer for _eventCb */
+    volatile uint32_t _eventMask; /**< Events reported to _eventCb */
+    volatile uint32_t _eventPending; /**< Deferred events not yet dispatched */
+    uint16_t _eventCount;         /**< Fill level for EVENT_RX_COUNT */
+    uint8_t _eventDelimiter;      /**< Byte for EVENT_RX_DELIMITER */
+    bool _eventDeferred;          /**< Dispatch from _eventIrq instead of the UART ISR */
+    IRQn_Type _eventIrq;          /**< Software-pended interrupt for deferred dispatch */
+    bool _rs485;                  /**< RS-485 half-duplex mode enabled */
+    Rs485Config _rs485Cfg;        /**< RS-485 settings */
+    volatile bool _deAsserted;    /**< true while this node drives the bus */
+
+    static constexpr uint8_t XON = 0x11;   /**< Resume transmission (DC1) */
+    static constexpr uint8_t XOFF = 0x13;  /**< Pause transmission (DC3) */
 
     static constexpr int MAX_UARTS = 6; /**< Max number of UART instances supported */
     static STM32BufferedSerial* instance_table_[MAX_UARTS]; /**< Global UART-to-instance map */
@@ -153,11 +764,211 @@ private:
     /** @brief Begin transmission via interrupt. */
     void _startTxInterrupt();
 
-    /** @brief Push one byte into RX buffer. */
+    /** @brief Start the next chunk if the transmitter is idle (interrupts masked by the caller). */
+    void _startTxNext();
+
+    /** @brief Clock feeding the USART baud rate generator (PCLK2 for USART1/6, PCLK1 otherwise). */
+    uint32_t _uartClock() const;
+
+    /** @brief Measure the first frame on the RX pin (auto-baud without hardware support). */
+    bool _measureBaud(GPIO_TypeDef* rxPort, uint16_t rxPin, uint32_t timeoutMs, uint32_t& baud, int& firstByte);
+
+    /** @brief RX ring size for a requested buffer size (next power of two, at most 32768). */
+    static uint16_t _rxRingSize(uint16_t bufSize);
+
+    /** @brief Output cursor over the free space of lane 0 (printf family). */
+    struct TxStage {
+        uint8_t* buf;             /**< Lane buffer */
+        uint16_t size;            /**< Lane size */
+        uint16_t pos;             /**< Next write index */
+        uint16_t left;            /**< Free bytes left */
+        uint16_t count;           /**< Bytes written */
+
+        void put(char c) {
+            if (!left) return;
+            buf[pos] = static_cast<uint8_t>(c);
+            pos = (pos + 1 == size) ? 0 : pos + 1;
+            left--;
+            count++;
+        }
+        void put(const char* s, uint16_t n) { while (n--) put(*s++); }
+        void pad(char c, int n) { while (n-- > 0) put(c); }
+    };
+
+    /** @brief Claim the free space of lane 0 for formatting. @return false if another call is formatting. */
+    bool _stageBegin(TxStage& st);
+
+    /** @brief Publish the formatted bytes as one frame and start transmission. */
+    int _stageCommit(const TxStage& st);
+
+    /** @brief Render a format string into a stage. */
+    static void _format(TxStage& st, const char* fmt, va_list& args);
+
+    /** @brief Append the CRC of a log record staged after LOG_SYNC. */
+    static void _logSeal(TxStage& st);
+
+    /** @brief Binary log argument encoding (see logRecord()). */
+    template <typename T>
+    static uint16_t _logArgSize(T) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                      "unsupported STM32BS_LOG argument type");
+        return (!std::is_floating_point<T>::value && sizeof(T) > 4) ? 8 : 4;
+    }
+    static uint16_t _logArgSize(const char* s) {
+        // strnlen() with a literal argument trips GCC's -Wstringop-overread
+        uint16_t n = 0;
+        while (n < 255 && s[n]) n++;
+        return 1 + n;
+    }
+    static uint16_t _logArgSize(char* s) { return _logArgSize(static_cast<const char*>(s)); }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, uint64_t>::type
+    _logBits(T v) { return static_cast<uint64_t>(v); }
+    template <typename T>
+    static uint64_t _logBits(T* p) { return reinterpret_cast<uintptr_t>(p); }
+    static uint64_t _logBits(float v) { uint32_t b; memcpy(&b, &v, 4); return b; }
+    static uint64_t _logBits(double v) { return _logBits(static_cast<float>(v)); }
+
+    static uint16_t _logSize() { return 0; }
+    template <typename T, typename... Rest>
+    static uint16_t _logSize(T v, Rest... rest) { return _logArgSize(v) + _logSize(rest...); }
+
+    static void _logPut(TxStage&) {}
+    template <typename T, typename... Rest>
+    static void _logPut(TxStage& st, T v, Rest... rest) {
+        uint64_t bits = _logBits(v);
+        for (uint16_t i = 0, n = _logArgSize(v); i < n; i++, bits >>= 8)
+            st.put(static_cast<char>(bits & 0xFF));
+        _logPut(st, rest...);
+    }
+    template <typename... Rest>
+    static void _logPut(TxStage& st, const char* s, Rest... rest) {
+        uint16_t n = _logArgSize(s) - 1;
+        st.put(static_cast<char>(n));
+        st.put(s, n);
+        _logPut(st, rest...);
+    }
+    template <typename... Rest>
+    static void _logPut(TxStage& st, char* s, Rest... rest) {
+        _logPut(st, static_cast<const char*>(s), rest...);
+    }
+
+    /** @brief Copy data into a TX lane (caller checks space) and publish it. */
+    void _txEnqueue(TxLane& q, const uint8_t* data, uint16_t len);
+
+    /** @brief Record a frame end at the current end of a lane. @return false if the marker queue is full. */
+    bool _txMark(TxLane& q, TxDoneCallback cb, void* ctx);
+
+    /** @brief Account for transmitted lane bytes and fire completed markers. */
+    void _txAdvance(uint8_t lane, uint16_t sent);
+
+    /** @brief Account for a transmitted chunk of the front sendBuffer() buffer. */
+    void _txExtAdvance(uint16_t sent);
+
+    /** @brief Start sending the front sendBuffer() buffer of the current lane. */
+    void _startTxExt(const TxMarker& m);
+
+    /** @brief true if a lane has ring data or a sendBuffer() buffer waiting. */
+    static bool _txPending(const TxLane& q);
+
+    /** @brief true if any lane has data waiting. */
+    bool _txAnyPending() const;
+
+    /** @brief Length of the next frame of a lane (for DRR). */
+    static uint32_t _txFrameLen(const TxLane& q);
+
+    /** @brief Choose the lane to transmit from next. @return Lane index, or -1 if all are empty. */
+    int _txPickLane();
+
+    /** @brief Free bytes in a lane. */
+    static uint16_t _txFree(const TxLane& q);
+
+    /** @brief Stop the in-flight ring transmit after the byte currently being sent. */
+    void _truncateTx();
+
+    /** @brief Take the RS-485 bus before transmitting. */
+    void _acquireBus();
+
+    /** @brief Release the RS-485 bus after the last byte left the shift register. */
+    void _releaseBus();
+
+    /** @brief Busy-wait for the given number of UART sample times. */
+    void _waitSampleTimes(uint8_t sampleTimes) const;
+
+    /** @brief Handle one received byte: XON/XOFF, or push into the RX buffer. */
+    void _receive(uint8_t c);
+
+    /** @brief Push one byte into RX buffer, applying the overflow policy. */
     void push(uint8_t c);
 
+    /** @brief Pause (true) or resume (false) the remote sender. */
+    void _setRxThrottle(bool throttle);
+
+    /** @brief Report events to the callback (directly or deferred). */
+    void _raiseEvents(uint32_t events);
+
+    /** @brief Record a frame end at the current RX position (ISR). */
+    void _markFrameEnd();
+
+    /** @brief Close the current burst: record its frame end and raise EVENT_RX_IDLE (ISR). */
+    void _endRxBurst();
+
+    /** @brief Index of the first frame end not yet consumed by the reader. */
+    uint8_t _firstLiveFrame() const;
+
+    /** @brief Resume the sender if the RX fill level dropped below the low watermark. */
+    void _checkRxRelease();
+
     /** @brief Pop one byte from RX buffer. */
     int pop();
 };
 
+/** @brief No-op whose only purpose is printf-style format checking of STM32BS_LOG(). */
+#if defined(__GNUC__)
+__attribute__((format(printf, 1, 2)))
+#endif
+inline void stm32bsLogFormatCheck(const char*, ...) {}
+
+/**
+ * @brief Deferred binary logging (format string ID plus raw arguments).
+ *
+ * The format string is emitted by inline assembly into the non-allocated
+ * `.stm32bs_log` section, so it costs no flash and is never formatted on the
+ * MCU; tools/stm32bs_logdecode.py turns the byte stream back into text using
+ * the ELF file. Works the same in inline functions and templates. @p fmt must
+ * be a string literal (adjacent literals and PRIu32-style macros are fine).
+ *
+ * Usage: `STM32BS_LOG(serial, "adc=%u t=%.1f", raw, temp);`
+ */
+#define STM32BS_LOG(serial, fmt, ...) STM32BS_LOG_AT_(__COUNTER__, serial, fmt, ##__VA_ARGS__)
+
+/** @cond INTERNAL */
+#if defined(__ARM_ARCH_6M__)
+#define STM32BS_LOG_ADDR_(sym) "ldr %0, =" sym
+#elif defined(__arm__)
+#define STM32BS_LOG_ADDR_(sym) "movw %0, #:lower16:" sym "\n\tmovt %0, #:upper16:" sym
+#elif defined(__x86_64__) || defined(__i386__)
+// Host tests only (build with -fno-pie)
+#define STM32BS_LOG_ADDR_(sym) "mov $" sym ", %0"
+#endif
+
+#define STM32BS_LOG_AT_(n, serial, fmt, ...) STM32BS_LOG_EMIT_(n, serial, fmt, ##__VA_ARGS__)
+// The string is placed with .pushsection rather than a section attribute, which conflicts
+// in inline functions and is ignored in templates. Each expansion gets its own local label,
+// defined once (.ifndef) even when the code is inlined or instantiated several times.
+#define STM32BS_LOG_EMIT_(n, serial, fmt, ...)                                          \
+    do {                                                                                 \
+        __asm__(".ifndef .Lstm32bs_log_" #n "\n\t"                                      \
+                ".pushsection .stm32bs_log,\"\",%progbits\n"                             \
+                ".Lstm32bs_log_" #n ": .asciz " #fmt "\n\t"                               \
+                ".popsection\n\t"                                                        \
+                ".endif");                                                               \
+        const char* _stm32bsLogFmt;                                                      \
+        __asm__(STM32BS_LOG_ADDR_(".Lstm32bs_log_" #n) : "=r"(_stm32bsLogFmt));          \
+        if (false) stm32bsLogFormatCheck(fmt, ##__VA_ARGS__);                            \
+        (serial).logRecord(_stm32bsLogFmt, ##__VA_ARGS__);                               \
+    } while (0)
+/** @endcond */
+
 #endif
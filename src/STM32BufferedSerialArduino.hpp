@@ -0,0 +1,120 @@
+/**
+ * @file STM32BufferedSerialArduino.hpp
+ * @brief Arduino Stream-compatible front end for STM32BufferedSerial.
+ *
+ * Lets drivers written against Arduino's Stream (GPS, lidar, servo libraries)
+ * run on the HAL ring buffers:
+ * @code
+ * STM32BufferedSerial serial(&huart2, 256);
+ * STM32BufferedSerialArduino gpsPort(serial);
+ *
+ * gpsPort.setTimeout(50);
+ * char line[96];
+ * size_t n = gpsPort.readBytesUntil('\n', line, sizeof(line));
+ * @endcode
+ *
+ * - peek() is O(1); readBytes() uses bulk copies; find() and readBytesUntil()
+ *   scan the buffered data in place and consume it in one step.
+ * - Timed operations wait with __WFI() and HAL_GetTick() (default timeout 1000 ms).
+ * - When ARDUINO is defined the class derives from ::Stream, so it can be passed
+ *   as Stream&; the efficient find() / readBytes() / readBytesUntil() then apply
+ *   when called through this type.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_ARDUINO_HPP
+#define STM32_BUFFERED_SERIAL_ARDUINO_HPP
+
+#include "STM32BufferedSerial.hpp"
+#include <cstddef>
+
+#if defined(ARDUINO)
+#include <Stream.h>
+#define STM32BS_ARDUINO_BASE : public Stream
+#define STM32BS_ARDUINO_OVERRIDE override
+#else
+#define STM32BS_ARDUINO_BASE
+#define STM32BS_ARDUINO_OVERRIDE
+#ifndef DEC
+#define DEC 10
+#endif
+#ifndef HEX
+#define HEX 16
+#endif
+#ifndef OCT
+#define OCT 8
+#endif
+#ifndef BIN
+#define BIN 2
+#endif
+#endif
+
+/**
+ * @class STM32BufferedSerialArduino
+ * @brief Stream API (available / read / peek / readBytes / find / print ...) over one serial instance.
+ */
+class STM32BufferedSerialArduino STM32BS_ARDUINO_BASE {
+public:
+    /** @brief Construct the front end. @param serial Serial instance to wrap. */
+    explicit STM32BufferedSerialArduino(STM32BufferedSerial& serial);
+
+    /** @brief Number of bytes ready to read (Stream semantics, unlike STM32BufferedSerial::available()). */
+    int available() STM32BS_ARDUINO_OVERRIDE;
+    int read() STM32BS_ARDUINO_OVERRIDE;
+    int peek() STM32BS_ARDUINO_OVERRIDE;
+    size_t write(uint8_t c) STM32BS_ARDUINO_OVERRIDE;
+    size_t write(const uint8_t* buf, size_t len) STM32BS_ARDUINO_OVERRIDE;
+    int availableForWrite() STM32BS_ARDUINO_OVERRIDE;
+
+    /** @brief Wait until all queued output has been sent (Arduino semantics, not flushRx()). */
+    void flush() STM32BS_ARDUINO_OVERRIDE;
+
+    size_t write(const char* s);
+
+    /** @brief Timeout of the timed read operations in milliseconds. */
+    void setTimeout(unsigned long timeoutMs) { _timeout = timeoutMs; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    /** @brief Read @p length bytes or until the timeout. @return Number of bytes read. */
+    size_t readBytes(uint8_t* buffer, size_t length);
+    size_t readBytes(char* buffer, size_t length) { return readBytes(reinterpret_cast<uint8_t*>(buffer), length); }
+
+    /** @brief Read until @p terminator (consumed, not stored), @p length bytes or the timeout. */
+    size_t readBytesUntil(char terminator, uint8_t* buffer, size_t length);
+    size_t readBytesUntil(char terminator, char* buffer, size_t length) {
+        return readBytesUntil(terminator, reinterpret_cast<uint8_t*>(buffer), length);
+    }
+
+    /** @brief Consume input up to and including @p target. @return false on timeout. */
+    bool find(const char* target);
+    bool find(const char* target, size_t length);
+
+    /** @brief Skip to the next integer and parse it (0 on timeout). */
+    long parseInt();
+
+#if !defined(ARDUINO)
+    size_t print(const char* s) { return static_cast<size_t>(_serial.print(s)); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(int v, int base = DEC) { return print(static_cast<long>(v), base); }
+    size_t print(unsigned int v, int base = DEC) { return print(static_cast<unsigned long>(v), base); }
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC) {
+        return static_cast<size_t>(_serial.print(v, static_cast<uint8_t>(base)));
+    }
+    size_t print(double v, int digits = 2) { return static_cast<size_t>(_serial.print(v, static_cast<uint8_t>(digits))); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <typename T>
+    size_t println(T v, int format) { size_t n = print(v, format); return n + println(); }
+#endif
+
+private:
+    STM32BufferedSerial& _serial;  /**< Wrapped serial instance */
+    unsigned long _timeout;        /**< Timed read timeout [ms] */
+
+    /** @brief Wait for an interrupt. @return false once the timeout since @p start has expired. */
+    bool _waitUntil(uint32_t start) const;
+};
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * @file STM32BufferedSerialAsync.hpp
+ * @brief C++20 coroutine front end for STM32BufferedSerial.
+ *
+ * Provides awaitable reads and writes so that one task can drive several
+ * UARTs concurrently without threads:
+ * @code
+ * AsyncScheduler scheduler;
+ * AsyncSerial port(serial, scheduler);
+ *
+ * AsyncTask echoLines() {
+ *     uint8_t line[64];
+ *     for (;;) {
+ *         uint16_t n = co_await port.readUntil(line, sizeof(line), '\n');
+ *         co_await port.writeAsync({line, n});
+ *     }
+ * }
+ *
+ * int main() {
+ *     ...
+ *     port.begin();
+ *     scheduler.spawn(echoLines());
+ *     scheduler.run();
+ * }
+ * @endcode
+ *
+ * - The UART ISR completes the transfer and posts the suspended coroutine to a
+ *   lock-free ready queue; the scheduler resumes it in thread context.
+ * - Coroutine frames come from a static pool (STM32BS_ASYNC_FRAMES blocks of
+ *   STM32BS_ASYNC_FRAME_SIZE bytes); nothing is allocated from the heap.
+ *   Coroutines must be created from thread context.
+ * - The ready queue holds at least one slot per frame, so a completion is never lost.
+ *
+ * @note AsyncSerial owns the event callback of the serial instance.
+ * @note Requires C++20 (-std=c++20 / gnu++20).
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_ASYNC_HPP
+#define STM32_BUFFERED_SERIAL_ASYNC_HPP
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include "STM32BufferedSerial.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <span>
+
+#ifndef STM32BS_ASYNC_FRAMES
+/** Number of coroutine frames in the static pool. */
+#define STM32BS_ASYNC_FRAMES 8
+#endif
+
+#ifndef STM32BS_ASYNC_FRAME_SIZE
+/** Size of one coroutine frame block in bytes. */
+#define STM32BS_ASYNC_FRAME_SIZE 256
+#endif
+
+#ifndef STM32BS_ASYNC_READY_QUEUE
+/** Ready queue length (power of two, at least STM32BS_ASYNC_FRAMES). */
+#define STM32BS_ASYNC_READY_QUEUE 16
+#endif
+
+/**
+ * @class AsyncFramePool
+ * @brief Fixed-block storage for coroutine frames.
+ */
+class AsyncFramePool {
+public:
+    /** @brief Allocate a frame block. @return nullptr if @p size is too large or the pool is exhausted. */
+    static void* allocate(std::size_t size) noexcept;
+
+    /** @brief Return a frame block to the pool. */
+    static void release(void* p) noexcept;
+};
+
+/**
+ * @class AsyncTask
+ * @brief Fire-and-forget coroutine started by AsyncScheduler::spawn().
+ */
+class AsyncTask {
+public:
+    struct promise_type {
+        AsyncTask get_return_object() noexcept {
+            return AsyncTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        static AsyncTask get_return_object_on_allocation_failure() noexcept { return AsyncTask(nullptr); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+
+        static void* operator new(std::size_t size) noexcept { return AsyncFramePool::allocate(size); }
+        static void operator delete(void* p) noexcept { AsyncFramePool::release(p); }
+    };
+
+    AsyncTask(AsyncTask&& other) noexcept : _handle(other._handle) { other._handle = nullptr; }
+    AsyncTask(const AsyncTask&) = delete;
+    AsyncTask& operator=(const AsyncTask&) = delete;
+    ~AsyncTask() { if (_handle) _handle.destroy(); }
+
+    /** @brief false if the frame could not be allocated. */
+    explicit operator bool() const { return static_cast<bool>(_handle); }
+
+    /** @brief Give up ownership of the coroutine handle. */
+    std::coroutine_handle<> release() {
+        std::coroutine_handle<> h = _handle;
+        _handle = nullptr;
+        return h;
+    }
+
+private:
+    explicit AsyncTask(std::coroutine_handle<promise_type> h) : _handle(h) {}
+    std::coroutine_handle<promise_type> _handle;
+};
+
+/**
+ * @class AsyncScheduler
+ * @brief Runs coroutines posted to a lock-free ready queue.
+ *
+ * post() may be called from any interrupt priority; run() / runOnce() from thread context only.
+ */
+class AsyncScheduler {
+public:
+    AsyncScheduler();
+
+    /** @brief Start a coroutine. @return false if the frame pool or the ready queue is exhausted. */
+    bool spawn(AsyncTask&& task);
+
+    /** @brief Queue a suspended coroutine for resumption (ISR safe). @return false if the queue is full. */
+    bool post(std::coroutine_handle<> h);
+
+    /** @brief Resume one ready coroutine. @return false if none was ready. */
+    bool runOnce();
+
+    /** @brief Resume coroutines forever, sleeping in WFI when none is ready. */
+    [[noreturn]] void run();
+
+private:
+    static_assert((STM32BS_ASYNC_READY_QUEUE & (STM32BS_ASYNC_READY_QUEUE - 1)) == 0,
+                  "STM32BS_ASYNC_READY_QUEUE must be a power of two");
+    // A coroutine occupies at most one slot, so post() cannot fail for pooled frames
+    static_assert(STM32BS_ASYNC_READY_QUEUE >= STM32BS_ASYNC_FRAMES,
+                  "STM32BS_ASYNC_READY_QUEUE must be at least STM32BS_ASYNC_FRAMES");
+
+    struct Slot {
+        std::atomic<uint32_t> seq;  /**< Slot sequence (bounded MPSC queue) */
+        void* address;              /**< coroutine_handle address */
+    };
+    Slot _slots[STM32BS_ASYNC_READY_QUEUE]; /**< Ready queue storage */
+    std::atomic<uint32_t> _tail;            /**< Producer position */
+    uint32_t _head;                         /**< Consumer position */
+};
+
+/**
+ * @class AsyncSerial
+ * @brief Awaitable reads and writes on one STM32BufferedSerial instance.
+ *
+ * At most one read and one write may be pending at a time.
+ */
+class AsyncSerial {
+public:
+    /** @brief State of one read operation (lives in the awaiting coroutine's frame). */
+    struct RxOp {
+        uint8_t* buf;                   /**< Destination */
+        uint16_t len;                   /**< Requested / maximum length */
+        uint16_t got;                   /**< Bytes received so far */
+        bool until;                     /**< Stop at delimiter */
+        uint8_t delimiter;              /**< Delimiter for readUntil() */
+        std::coroutine_handle<> handle; /**< Suspended coroutine */
+    };
+
+    /** @brief State of one write operation. */
+    struct TxOp {
+        const uint8_t* data;            /**< Source */
+        uint16_t len;                   /**< Total length */
+        uint16_t sent;                  /**< Bytes queued so far */
+        std::coroutine_handle<> handle; /**< Suspended coroutine */
+    };
+
+    /** @brief Awaitable returned by readAsync() / readUntil(); yields the byte count. */
+    struct ReadAwaitable {
+        AsyncSerial& port;
+        RxOp op;
+        bool await_ready() { return port._rxProgress(op); }
+        bool await_suspend(std::coroutine_handle<> h) { return port._rxSuspend(op, h); }
+        uint16_t await_resume() const { return op.got; }
+    };
+
+    /** @brief Awaitable returned by writeAsync(); yields the byte count. */
+    struct WriteAwaitable {
+        AsyncSerial& port;
+        TxOp op;
+        bool await_ready() { return port._txProgress(op); }
+        bool await_suspend(std::coroutine_handle<> h) { return port._txSuspend(op, h); }
+        uint16_t await_resume() const { return op.sent; }
+    };
+
+    /**
+     * @brief Construct the front end.
+     * @param serial Serial instance to drive.
+     * @param scheduler Scheduler that resumes the awaiting coroutines.
+     */
+    AsyncSerial(STM32BufferedSerial& serial, AsyncScheduler& scheduler);
+
+    /** @brief Install the event callback on the serial instance. */
+    void begin();
+
+    /** @brief Complete when exactly @p len bytes have been read into @p buf. */
+    ReadAwaitable readAsync(uint8_t* buf, uint16_t len) {
+        return ReadAwaitable{*this, RxOp{buf, len, 0, false, 0, nullptr}};
+    }
+
+    /** @brief Complete when @p delimiter has been read (included) or @p max bytes were read. */
+    ReadAwaitable readUntil(uint8_t* buf, uint16_t max, uint8_t delimiter = '\n') {
+        return ReadAwaitable{*this, RxOp{buf, max, 0, true, delimiter, nullptr}};
+    }
+
+    /** @brief Complete when all of @p data has been queued for transmission. */
+    WriteAwaitable writeAsync(std::span<const uint8_t> data) {
+        return WriteAwaitable{*this, TxOp{data.data(), static_cast<uint16_t>(data.size()), 0, nullptr}};
+    }
+
+private:
+    STM32BufferedSerial& _serial;  /**< Driven serial instance */
+    AsyncScheduler& _scheduler;    /**< Scheduler for resumption */
+    RxOp* volatile _rxOp;          /**< Pending read (nullptr if none) */
+    TxOp* volatile _txOp;          /**< Pending write (nullptr if none) */
+
+    bool _rxProgress(RxOp& op);
+    bool _rxSuspend(RxOp& op, std::coroutine_handle<> h);
+    bool _txProgress(TxOp& op);
+    bool _txSuspend(TxOp& op, std::coroutine_handle<> h);
+
+    /** @brief Recompute the serial event mask and RX count trigger. */
+    void _arm();
+
+    /** @brief Serial event callback (ISR context). */
+    static void _onEvent(STM32BufferedSerial& serial, uint32_t events, void* context);
+};
+
+#endif
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @file STM32BufferedSerialRetarget.hpp
+ * @brief Route newlib stdio (printf, puts, fgets, ...) through STM32BufferedSerial.
+ *
+ * Build with `-DSTM32BS_RETARGET_STDIO` to get `_write()` / `_read()` definitions
+ * that replace the weak ones in the CubeMX-generated syscalls.c:
+ * - `_write(1 / 2, ...)` queues into the TX ring (interrupt-driven, no HAL_UART_Transmit()).
+ * - `_read(0, ...)` returns buffered RX data.
+ *
+ * @code
+ * STM32BufferedSerial serial(&huart2, 512);
+ *
+ * int main() {
+ *     ...
+ *     serial.begin();
+ *     stm32bsRetargetStdio(serial);
+ *     printf("hello\n");
+ * }
+ * @endcode
+ *
+ * @note Calls from interrupt handlers never wait: output that does not fit is dropped.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_RETARGET_HPP
+#define STM32_BUFFERED_SERIAL_RETARGET_HPP
+
+#include "STM32BufferedSerial.hpp"
+
+/** @brief What _write() / _read() do when the ring is full / empty. */
+enum Stm32bsRetargetMode : uint8_t {
+    STM32BS_RETARGET_BLOCK,      /**< Wait (in __WFI) until everything is queued / at least one byte arrived */
+    STM32BS_RETARGET_NONBLOCK,   /**< Queue what fits and drop the rest; _read() fails with EAGAIN when empty */
+};
+
+/**
+ * @brief Select the instance used for stdin / stdout / stderr.
+ * @param serial Serial instance (nullptr to detach; stdio output is then discarded).
+ * @param mode Behaviour when the TX ring is full or the RX ring is empty.
+ */
+void stm32bsRetargetStdio(STM32BufferedSerial* serial, Stm32bsRetargetMode mode = STM32BS_RETARGET_BLOCK);
+
+/** @brief Reference overload of stm32bsRetargetStdio(). */
+inline void stm32bsRetargetStdio(STM32BufferedSerial& serial, Stm32bsRetargetMode mode = STM32BS_RETARGET_BLOCK) {
+    stm32bsRetargetStdio(&serial, mode);
+}
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file STM32BufferedSerialRtos.hpp
+ * @brief FreeRTOS adapter with blocking read / write for STM32BufferedSerial.
+ *
+ * The calling task sleeps on a direct-to-task notification and the UART ISR
+ * wakes it only when the requested number of bytes (or the delimiter) has
+ * arrived, or when TX buffer space has been freed. There is no polling and no
+ * vTaskDelay() latency.
+ *
+ * Typical usage:
+ * @code
+ * STM32BufferedSerial serial(&huart2, 256);
+ * STM32BufferedSerialRtos port(serial);
+ *
+ * void task(void*) {
+ *     serial.begin();
+ *     port.begin();
+ *     uint8_t hdr[4];
+ *     if (port.read(hdr, sizeof(hdr), pdMS_TO_TICKS(100)) == sizeof(hdr)) {
+ *         ...
+ *     }
+ * }
+ * @endcode
+ *
+ * @note The adapter owns the event callback of the serial instance.
+ *       Do not enable PendSV event deferral: FreeRTOS uses PendSV itself.
+ * @note One task may block in read() and another in write() at the same time.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_RTOS_HPP
+#define STM32_BUFFERED_SERIAL_RTOS_HPP
+
+#include "STM32BufferedSerial.hpp"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @class STM32BufferedSerialRtos
+ * @brief Blocking, task-notification based front end for STM32BufferedSerial.
+ */
+class STM32BufferedSerialRtos {
+public:
+    /**
+     * @brief Construct the adapter.
+     * @param serial Serial instance to wrap.
+     */
+    explicit STM32BufferedSerialRtos(STM32BufferedSerial& serial);
+
+    /** @brief Install the event callback on the serial instance. */
+    void begin();
+
+    /**
+     * @brief Read exactly @p len bytes, blocking until they arrive or the timeout expires.
+     * @param dst Destination buffer.
+     * @param len Number of bytes wanted.
+     * @param timeout Timeout in ticks (portMAX_DELAY to wait forever).
+     * @return Number of bytes read (less than @p len on timeout).
+     */
+    int read(uint8_t* dst, uint16_t len, TickType_t timeout);
+
+    /**
+     * @brief Read up to and including @p delimiter.
+     * @param dst Destination buffer.
+     * @param max Size of @p dst.
+     * @param delimiter Terminating byte (e.g. '\\n').
+     * @param timeout Timeout in ticks.
+     * @return Number of bytes read. The last byte is the delimiter unless @p max was reached or the wait timed out.
+     */
+    int readUntil(uint8_t* dst, uint16_t max, uint8_t delimiter, TickType_t timeout);
+
+    /**
+     * @brief Queue @p len bytes, blocking while the TX buffer is full.
+     * @param src Data to send.
+     * @param len Number of bytes.
+     * @param timeout Timeout in ticks.
+     * @return Number of bytes queued (less than @p len on timeout).
+     */
+    int write(const uint8_t* src, uint16_t len, TickType_t timeout);
+
+private:
+    STM32BufferedSerial& _serial;         /**< Wrapped serial instance */
+    volatile TaskHandle_t _rxWaiter;      /**< Task blocked in read() */
+    volatile TaskHandle_t _txWaiter;      /**< Task blocked in write() */
+    volatile uint32_t _rxEvents;          /**< Events the reader waits for */
+    volatile uint32_t _txEvents;          /**< Events the writer waits for */
+
+    /** @brief Update the serial event mask from _rxEvents / _txEvents. */
+    void _updateMask();
+
+    /** @brief Block the calling task until notified or the timeout expires. @return false on timeout. */
+    bool _wait(TimeOut_t& timeOut, TickType_t& remaining);
+
+    /** @brief Serial event callback (ISR context). */
+    static void _onEvent(STM32BufferedSerial& serial, uint32_t events, void* context);
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file STM32BufferedSerialStream.hpp
+ * @brief std::streambuf backed directly by the STM32BufferedSerial ring buffers.
+ *
+ * Output goes straight into the TX ring (txReserve() / txCommit()) and the get area
+ * is the contiguous readable region of the RX ring (rxPeekContiguous()), so
+ * stream insertions and extractions need no intermediate buffer:
+ * @code
+ * STM32BufferedSerialStreambuf buf(serial);
+ * std::ostream out(&buf);
+ * std::istream in(&buf);
+ * out << "t=" << temperature << std::endl;
+ * int setpoint;
+ * in >> setpoint;
+ * @endcode
+ *
+ * - There is no put area: each character inserted on its own is committed to the
+ *   TX ring before overflow() returns, so the stream never holds a TX reservation
+ *   and other lane-0 writers (write(), printf()) are not blocked. Transmission
+ *   starts without a flush.
+ * - Bulk insertions (sputn / write) copy with write().
+ * - In blocking mode (default) overflow / underflow wait in __WFI() for the UART
+ *   interrupt; from an interrupt handler they never wait.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_STREAM_HPP
+#define STM32_BUFFERED_SERIAL_STREAM_HPP
+
+#include "STM32BufferedSerial.hpp"
+#include <streambuf>
+
+/**
+ * @class STM32BufferedSerialStreambuf
+ * @brief Zero-copy stream buffer over one serial instance (TX lane 0 and the RX ring).
+ */
+class STM32BufferedSerialStreambuf : public std::streambuf {
+public:
+    /**
+     * @brief Construct the stream buffer.
+     * @param serial Serial instance.
+     * @param blocking Wait for TX space / RX data instead of failing (end of file).
+     */
+    explicit STM32BufferedSerialStreambuf(STM32BufferedSerial& serial, bool blocking = true);
+
+    /** @brief Releases the RX region. */
+    ~STM32BufferedSerialStreambuf() override;
+
+protected:
+    int_type overflow(int_type c) override;
+    int_type underflow() override;
+    int sync() override;
+    std::streamsize showmanyc() override;
+    std::streamsize xsputn(const char_type* s, std::streamsize n) override;
+    std::streamsize xsgetn(char_type* s, std::streamsize n) override;
+
+private:
+    STM32BufferedSerial& _serial;  /**< Backing serial instance */
+    bool _blocking;                /**< Wait instead of failing */
+
+    /** @brief Consume the bytes read from the get area and drop it. */
+    void _releaseGet();
+
+    /** @brief Wait for an interrupt if blocking is allowed. @return false if the caller must give up. */
+    bool _wait() const;
+};
+
+#endif
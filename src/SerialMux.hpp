@@ -0,0 +1,206 @@
+/**
+ * @file SerialMux.hpp
+ * @brief Several logical byte streams over one STM32BufferedSerial.
+ *
+ * Each channel has its own TX and RX ring. poll() cuts queued TX data into
+ * chunks and picks the next channel with deficit round robin, so a bulk
+ * channel gets its quantum per round and no more. Only the chunk on the
+ * wire and the next one are queued in the serial port, so a chunk of a
+ * newly active channel never waits behind a full TX buffer of bulk data.
+ *
+ * Frame format (HDLC-style byte stuffing from Hdlc.hpp, as in ArqLink):
+ * @code
+ * 0x7E | type:4 chan:4 | offset(2, LE) | payload | crc16(2, LE) | 0x7E
+ * @endcode
+ * - DATA:   offset = stream position of the first payload byte
+ * - CREDIT: offset = stream position up to which the sender may transmit
+ *
+ * Flow control is credit based. The receiver advertises how far into the
+ * channel stream its RX ring has room, and the sender never goes past
+ * that. A full channel therefore stalls only itself, never the shared
+ * line. Both values are absolute stream positions, so a lost CREDIT frame
+ * is healed by the next one, and a chunk lost to a CRC error is
+ * skipped without shrinking the window. Delivery is best effort (use
+ * ArqLink where a lost chunk matters). CREDIT frames use the highest TX
+ * lane so they are not queued behind bulk data.
+ *
+ * Typical usage:
+ * @code
+ * SerialMux mux(serial);
+ * mux.begin();
+ * mux.setWeight(MUX_CONSOLE, 16);   // small quantum, low latency
+ *
+ * while (1) {
+ *     mux.poll();
+ *     mux.write(MUX_TELEMETRY, sample, sizeof(sample));
+ *     int n = mux.read(MUX_COMMAND, cmd, sizeof(cmd));
+ * }
+ * @endcode
+ *
+ * @note read(), write() and poll() must be called from the same context.
+ *       Both ends must use the same STM32BS_MUX_* settings.
+ */
+
+#ifndef STM32_BUFFERED_SERIAL_SERIAL_MUX_HPP
+#define STM32_BUFFERED_SERIAL_SERIAL_MUX_HPP
+
+#include "STM32BufferedSerial.hpp"
+#include "Hdlc.hpp"
+#include <cstdint>
+
+#ifndef STM32BS_MUX_CHANNELS
+/** Number of logical channels (1-16). */
+#define STM32BS_MUX_CHANNELS 4
+#endif
+
+#ifndef STM32BS_MUX_RING_SIZE
+/** RX and TX ring size per channel (power of two). Also the initial credit. */
+#define STM32BS_MUX_RING_SIZE 256
+#endif
+
+#ifndef STM32BS_MUX_CHUNK
+/** Maximum payload bytes per chunk. */
+#define STM32BS_MUX_CHUNK 64
+#endif
+
+#ifndef STM32BS_MUX_CREDIT_REFRESH_MS
+/** Interval at which each channel's credit is re-advertised even if unchanged. */
+#define STM32BS_MUX_CREDIT_REFRESH_MS 100
+#endif
+
+/**
+ * @class SerialMux
+ * @brief Channel multiplexer with DRR scheduling and credit-based flow control.
+ */
+class SerialMux {
+public:
+    static constexpr uint8_t CHANNELS = STM32BS_MUX_CHANNELS;   /**< Number of channels */
+    static constexpr uint16_t RING_SIZE = STM32BS_MUX_RING_SIZE; /**< Ring size per channel and direction */
+    static constexpr uint16_t CHUNK = STM32BS_MUX_CHUNK;         /**< Maximum chunk payload */
+
+    static_assert(CHANNELS >= 1 && CHANNELS <= 16, "STM32BS_MUX_CHANNELS must be 1-16");
+    static_assert(RING_SIZE >= 16 && RING_SIZE <= 16384 && (RING_SIZE & (RING_SIZE - 1)) == 0,
+                  "STM32BS_MUX_RING_SIZE must be a power of two (16-16384)");
+    static_assert(CHUNK >= 1 && CHUNK <= RING_SIZE, "STM32BS_MUX_CHUNK must be 1..RING_SIZE");
+
+    /** @brief Multiplexer counters. */
+    struct Stats {
+        uint32_t chunksSent;     /**< DATA chunks sent */
+        uint32_t creditsSent;    /**< CREDIT frames sent */
+        uint32_t chunksReceived; /**< DATA chunks received with a valid CRC */
+        uint32_t crcErrors;      /**< Frames dropped because of a CRC mismatch or bad length */
+        uint32_t lostBytes;      /**< Stream bytes skipped because a chunk was lost */
+        uint32_t overflows;      /**< Bytes dropped because the peer exceeded its credit */
+    };
+
+    /**
+     * @brief Construct a multiplexer.
+     * @param serial Serial port carrying the channels (exclusively).
+     */
+    explicit SerialMux(STM32BufferedSerial& serial);
+
+    /** @brief Clear all channels and restore the initial credit. */
+    void begin();
+
+    /** @brief Receive chunks, advertise credit and send queued data. Call from the main loop. */
+    void poll();
+
+    /**
+     * @brief Queue data on a channel.
+     * @param channel Channel index.
+     * @param data Pointer to data.
+     * @param len Number of bytes.
+     * @return Number of bytes queued (limited by the channel's TX ring).
+     */
+    int write(uint8_t channel, const uint8_t* data, uint16_t len);
+
+    /**
+     * @brief Read received data from a channel.
+     * @param channel Channel index.
+     * @param dst Destination buffer.
+     * @param len Maximum number of bytes.
+     * @return Number of bytes copied.
+     */
+    int read(uint8_t channel, uint8_t* dst, uint16_t len);
+
+    /** @brief Bytes waiting in a channel's RX ring. */
+    int available(uint8_t channel) const;
+
+    /** @brief Free space in a channel's TX ring. */
+    int writable(uint8_t channel) const;
+
+    /** @brief Bytes the peer currently lets this side send on a channel. */
+    uint16_t credit(uint8_t channel) const;
+
+    /** @brief Set the DRR quantum of a channel in bytes per round (default CHUNK, 0 is treated as 1). */
+    void setWeight(uint8_t channel, uint16_t quantum);
+
+    /** @brief Multiplexer counters. */
+    const Stats& getStats() const { return _stats; }
+
+private:
+    static constexpr uint8_t HEADER = 3;                   /**< type/chan + offset */
+    static constexpr uint16_t MAX_RAW = HEADER + CHUNK + 2; /**< Unstuffed frame incl. CRC */
+    static constexpr uint8_t TX_DEPTH = 2;                 /**< DATA frames queued in the serial port (on the wire + next) */
+
+    /** @brief Per-channel state. */
+    struct Channel {
+        uint8_t rx[RING_SIZE];   /**< Received, unread bytes */
+        uint8_t tx[RING_SIZE];   /**< Queued, unsent bytes */
+        uint16_t rxHead;         /**< RX write index (free running) */
+        uint16_t rxTail;         /**< RX read index (free running) */
+        uint16_t txHead;         /**< TX write index (free running) */
+        uint16_t txTail;         /**< TX send index (free running) */
+        uint16_t rxExpected;     /**< Stream position of the next expected byte */
+        uint16_t txSent;         /**< Stream position of the next byte to send */
+        uint16_t txLimit;        /**< Stream position advertised by the peer */
+        uint16_t advertised;     /**< Credit limit last sent to the peer */
+        uint32_t advertisedAt;   /**< HAL tick of the last CREDIT frame */
+        uint16_t quantum;        /**< DRR quantum in bytes */
+        uint32_t deficit;        /**< DRR deficit counter */
+    };
+
+    STM32BufferedSerial& _serial;  /**< Underlying serial port */
+    Channel _ch[CHANNELS];         /**< Channels */
+    uint8_t _drrNext;              /**< Channel whose DRR turn is current */
+    bool _drrGranted;              /**< _drrNext already received its quantum this turn */
+    uint8_t _dataQueued;           /**< DATA frames handed to the serial port */
+    volatile uint8_t _dataSent;    /**< DATA frames fully transmitted (TX complete ISR) */
+
+    uint8_t _rxFrame[MAX_RAW];     /**< Frame being unstuffed */
+    HdlcDecoder _rxDecoder;        /**< Unstuffs received bytes into _rxFrame */
+
+    uint8_t _txFrame[2 * MAX_RAW + 2]; /**< Stuffed frame being queued */
+
+    Stats _stats;                  /**< Counters */
+
+    /** @brief Validate and dispatch an unstuffed frame. */
+    void _handleFrame(const uint8_t* frame, uint16_t len);
+
+    /** @brief Copy a DATA chunk into a channel's RX ring. */
+    void _handleData(Channel& ch, uint16_t offset, const uint8_t* payload, uint16_t len);
+
+    /** @brief Send CREDIT frames that are due. */
+    void _sendCredits(uint32_t now);
+
+    /** @brief Run DRR over the channels until the line is full or nothing is sendable. */
+    void _schedule();
+
+    /** @brief Sendable bytes of a channel (queued and covered by credit). */
+    uint16_t _sendable(uint8_t channel) const;
+
+    /**
+     * @brief Stuff and queue one frame.
+     * @param lane TX lane of the serial port.
+     * @param done Called from the TX complete interrupt when the frame has been sent (may be nullptr).
+     * @return false if it did not fit (nothing queued).
+     */
+    bool _sendFrame(uint8_t lane, uint8_t type, uint8_t channel, uint16_t offset,
+                    const uint8_t* a, uint16_t aLen, const uint8_t* b, uint16_t bLen,
+                    STM32BufferedSerial::TxDoneCallback done = nullptr);
+
+    /** @brief TX completion of a DATA frame (ISR context). */
+    static void _onDataSent(STM32BufferedSerial& serial, void* context);
+};
+
+#endif
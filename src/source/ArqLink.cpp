@@ -0,0 +1,367 @@
+#include "../ArqLink.hpp"
+#include "../Crc16.hpp"
+#include <cstring>
+
+namespace {
+constexpr uint8_t CTRL_DATA = 0x01;
+constexpr uint8_t CTRL_SYN = 0x02;
+constexpr uint8_t CTRL_ACK = 0x04;
+constexpr uint8_t CTRL_RESYNC = 0x08;
+
+inline uint32_t le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+}
+
+ArqLink::ArqLink(STM32BufferedSerial& serial)
+    : _serial(serial),
+      _txPool(), _rxPool(),
+      _txBase(0), _txNext(0), _rxNext(0),
+      _rxSynced(false), _rxSynPhase(false), _synPending(true),
+      _ackPending(false), _ackDue(0), _linkUp(true),
+      _srtt(0), _rttvar(0), _rtoBase(STM32BS_ARQ_RTO_INIT_MS), _rto(STM32BS_ARQ_RTO_INIT_MS),
+      _rxFrame(), _rxDecoder(_rxFrame, MAX_RAW),
+      _txFrame(), _stats()
+{
+}
+
+void ArqLink::begin()
+{
+    for (uint8_t i = 0; i < WINDOW; i++) {
+        _txPool[i].tries = 0;
+        _txPool[i].acked = false;
+        _txPool[i].lost = false;
+        _rxPool[i].full = false;
+    }
+    _txBase = _txNext = _rxNext = 0;
+    _rxSynced = false;
+    _rxSynPhase = false;
+    _synPending = true;
+    _ackPending = false;
+    _linkUp = true;
+    _srtt = _rttvar = 0;
+    _rtoBase = _rto = STM32BS_ARQ_RTO_INIT_MS;
+    _rxDecoder.reset();
+    _stats = Stats();
+}
+
+/*----------------------------------------
+ * 送信 API
+ *----------------------------------------*/
+bool ArqLink::send(const uint8_t* data, uint16_t len)
+{
+    if (len == 0 || len > MTU || sendable() == 0)
+        return false;
+
+    TxSlot& slot = _txPool[_txNext & (WINDOW - 1)];
+    memcpy(slot.data, data, len);
+    slot.len = len;
+    slot.tries = 0;
+    slot.acked = false;
+    slot.lost = false;
+    _txNext++;
+    return true;
+}
+
+uint8_t ArqLink::sendable() const
+{
+    return WINDOW - static_cast<uint8_t>(_txNext - _txBase);
+}
+
+int ArqLink::receive(uint8_t* dst, uint16_t maxLen)
+{
+    RxSlot& slot = _rxPool[_rxNext & (WINDOW - 1)];
+    if (!_rxSynced || !slot.full)
+        return -1;
+
+    uint16_t n = slot.len < maxLen ? slot.len : maxLen;
+    memcpy(dst, slot.data, n);
+    slot.full = false;
+    _rxNext++;
+    _stats.delivered++;
+    return n;
+}
+
+/*----------------------------------------
+ * 周期処理
+ *----------------------------------------*/
+void ArqLink::poll()
+{
+    // 受信リングをその場でアンスタッフ（コピーは _rxFrame への 1 回だけ）
+    uint16_t avail;
+    const uint8_t* p;
+    while ((p = _serial.rxPeekContiguous(avail)) != nullptr && avail) {
+        for (uint16_t i = 0; i < avail; i++) {
+            HdlcDecoder::Result r = _rxDecoder.feed(p[i]);
+            if (r == HdlcDecoder::FRAME)
+                _handleFrame(_rxDecoder.frame(), _rxDecoder.length());
+            else if (r == HdlcDecoder::ERROR)
+                _stats.crcErrors++;
+        }
+        _serial.rxConsume(avail);
+    }
+
+    // 未送信フレームの初回送信とタイムアウトした未確認フレームの再送（古い順）
+    uint32_t now = HAL_GetTick();
+    bool timedOut = false;
+    uint8_t inFlight = static_cast<uint8_t>(_txNext - _txBase);
+    for (uint8_t i = 0; i < inFlight; i++) {
+        uint8_t seq = static_cast<uint8_t>(_txBase + i);
+        TxSlot& slot = _txPool[seq & (WINDOW - 1)];
+        if (slot.acked)
+            continue;
+        if (slot.tries && !slot.lost && now - slot.sentAt < _rto)
+            continue;
+        if (!_sendFrame(&slot, seq))
+            break;
+        if (slot.tries) {
+            _stats.retransmissions++;
+            if (!slot.lost)
+                timedOut = true;
+            slot.lost = false;
+            if (slot.tries >= STM32BS_ARQ_MAX_RETRIES)
+                _linkUp = false;
+        }
+        slot.sentAt = now;
+        if (slot.tries < 0xFF)
+            slot.tries++;
+    }
+
+    // タイムアウトごとに RTO を倍にする（窓が進めば推定値に戻る）
+    if (timedOut) {
+        _rto <<= 1;
+        if (_rto > STM32BS_ARQ_RTO_MAX_MS)
+            _rto = STM32BS_ARQ_RTO_MAX_MS;
+    }
+
+    // 載せるデータが無いまま遅延時間を過ぎた ACK は単独で送る
+    if (_ackPending && static_cast<int32_t>(now - _ackDue) >= 0)
+        _sendFrame(nullptr, 0);
+}
+
+/*----------------------------------------
+ * 受信フレーム処理
+ *----------------------------------------*/
+void ArqLink::_handleFrame(const uint8_t* frame, uint16_t len)
+{
+    if (len < HEADER + 2) {
+        _stats.crcErrors++;
+        return;
+    }
+    uint16_t crc = crc16Modbus(frame, len - 2);
+    if ((frame[len - 2] | (frame[len - 1] << 8)) != crc) {
+        _stats.crcErrors++;
+        return;
+    }
+    _stats.framesReceived++;
+
+    uint8_t ctrl = frame[0];
+    if (ctrl & CTRL_ACK)
+        _handleAck(frame[2], le32(&frame[3]));
+    if (ctrl & CTRL_RESYNC)
+        _synPending = true;  // 相手の受信側が未同期なので SYN と base を付け直す
+
+    if (!(ctrl & CTRL_DATA))
+        return;
+
+    uint16_t off = HEADER;
+    if (ctrl & CTRL_SYN) {
+        if (len < HEADER + 1 + 2) {
+            _stats.crcErrors++;
+            return;
+        }
+        // 未同期、または同期済みの相手が SYN を再開した（= 相手がリセットされた）
+        if (!_rxSynced || !_rxSynPhase) {
+            for (uint8_t i = 0; i < WINDOW; i++)
+                _rxPool[i].full = false;
+            _rxNext = frame[HEADER];
+            _rxSynced = true;
+            _rxSynPhase = true;
+            _synPending = true;
+        }
+        off++;
+    } else {
+        _rxSynPhase = false;
+    }
+
+    uint16_t payloadLen = len - 2 - off;
+    if (payloadLen == 0 || payloadLen > MTU) {
+        _stats.crcErrors++;
+        return;
+    }
+
+    if (!_ackPending) {
+        _ackPending = true;
+        _ackDue = HAL_GetTick() + STM32BS_ARQ_ACK_DELAY_MS;
+    }
+    if (!_rxSynced) {
+        // SYN を受けるまでは格納せず、RESYNC 付きの応答で SYN を要求する
+        _stats.duplicates++;
+        return;
+    }
+    _handleData(frame[1], &frame[off], payloadLen);
+}
+
+void ArqLink::_handleData(uint8_t seq, const uint8_t* payload, uint16_t len)
+{
+    // 受信窓 [_rxNext, _rxNext + WINDOW) の外は再送済みの古いフレームか窓超過
+    uint8_t offset = static_cast<uint8_t>(seq - _rxNext);
+    RxSlot& slot = _rxPool[seq & (WINDOW - 1)];
+    if (offset >= WINDOW || slot.full) {
+        _stats.duplicates++;
+        return;
+    }
+    memcpy(slot.data, payload, len);
+    slot.len = len;
+    slot.full = true;
+}
+
+void ArqLink::_handleAck(uint8_t ack, uint32_t sack)
+{
+    uint8_t inFlight = static_cast<uint8_t>(_txNext - _txBase);
+    uint8_t cumulative = static_cast<uint8_t>(ack - _txBase);
+    if (cumulative > inFlight)
+        return;  // 古い ACK
+
+    uint32_t now = HAL_GetTick();
+    bool sampled = false;
+    uint32_t rtt = 0;
+    for (uint8_t i = 0; i < inFlight; i++) {
+        uint8_t seq = static_cast<uint8_t>(_txBase + i);
+        bool covered = i < cumulative;
+        if (!covered && i > cumulative)
+            covered = (sack >> (i - cumulative - 1)) & 1;
+        TxSlot& slot = _txPool[seq & (WINDOW - 1)];
+        if (!covered || slot.acked || slot.tries == 0)
+            continue;
+        slot.acked = true;
+        // Karn: 再送したフレームは どの送信への ACK か分からないのでサンプルにしない
+        if (slot.tries == 1 && (!sampled || now - slot.sentAt < rtt)) {
+            rtt = now - slot.sentAt;
+            sampled = true;
+        }
+    }
+    if (sampled)
+        _rttSample(rtt);
+
+    // 順序が保たれる回線なので、後から送ったフレームが届いていれば手前の送信は失われている
+    bool later = false;
+    uint32_t laterSent = 0;
+    for (uint8_t i = inFlight; i-- > 0;) {
+        TxSlot& slot = _txPool[static_cast<uint8_t>(_txBase + i) & (WINDOW - 1)];
+        if (slot.acked) {
+            if (!later || static_cast<int32_t>(slot.sentAt - laterSent) > 0)
+                laterSent = slot.sentAt;
+            later = true;
+        } else if (later && slot.tries && static_cast<int32_t>(laterSent - slot.sentAt) > 0) {
+            slot.lost = true;
+        }
+    }
+
+    // 先頭から確認済みの分だけ窓を進める
+    bool advanced = false;
+    while (_txBase != _txNext && _txPool[_txBase & (WINDOW - 1)].acked) {
+        _txPool[_txBase & (WINDOW - 1)].acked = false;
+        _txPool[_txBase & (WINDOW - 1)].tries = 0;
+        _txBase++;
+        advanced = true;
+    }
+    if (advanced) {
+        _synPending = false;
+        _linkUp = true;
+        _rto = _rtoBase;
+    }
+}
+
+void ArqLink::_rttSample(uint32_t rtt)
+{
+    // Jacobson/Karels: SRTT は 8 倍、RTTVAR は 4 倍で保持
+    if (_srtt == 0) {
+        _srtt = rtt << 3;
+        _rttvar = rtt << 1;
+    } else {
+        int32_t delta = static_cast<int32_t>(rtt) - static_cast<int32_t>(_srtt >> 3);
+        _srtt += delta;
+        if (delta < 0)
+            delta = -delta;
+        _rttvar += delta - static_cast<int32_t>(_rttvar >> 2);
+    }
+    uint32_t rto = (_srtt >> 3) + (_rttvar ? _rttvar : 1);
+    if (rto < STM32BS_ARQ_RTO_MIN_MS)
+        rto = STM32BS_ARQ_RTO_MIN_MS;
+    if (rto > STM32BS_ARQ_RTO_MAX_MS)
+        rto = STM32BS_ARQ_RTO_MAX_MS;
+    _rtoBase = _rto = rto;
+}
+
+uint8_t ArqLink::_ackState(uint32_t& sack) const
+{
+    uint8_t i = 0;
+    while (i < WINDOW && _rxPool[(_rxNext + i) & (WINDOW - 1)].full)
+        i++;
+    uint8_t ack = static_cast<uint8_t>(_rxNext + i);
+
+    sack = 0;
+    for (uint8_t j = i + 1; j < WINDOW; j++) {
+        if (_rxPool[(_rxNext + j) & (WINDOW - 1)].full)
+            sack |= 1UL << (j - i - 1);
+    }
+    return ack;
+}
+
+/*----------------------------------------
+ * 送信フレーム生成
+ *----------------------------------------*/
+bool ArqLink::_sendFrame(const TxSlot* slot, uint8_t seq)
+{
+    uint8_t header[HEADER + 1];
+    uint8_t headerLen = HEADER;
+    uint32_t sack = 0;
+
+    header[0] = 0;
+    if (slot)
+        header[0] |= CTRL_DATA;
+    if (_rxSynced) {
+        header[0] |= CTRL_ACK;
+        header[2] = _ackState(sack);
+    } else {
+        header[0] |= CTRL_RESYNC;
+        header[2] = 0;
+    }
+    header[1] = seq;
+    header[3] = sack & 0xFF;
+    header[4] = (sack >> 8) & 0xFF;
+    header[5] = (sack >> 16) & 0xFF;
+    header[6] = sack >> 24;
+    if (slot && _synPending) {
+        header[0] |= CTRL_SYN;
+        header[headerLen++] = _txBase;
+    }
+
+    uint16_t crc = crc16Modbus(header, headerLen);
+    if (slot)
+        crc = crc16Modbus(slot->data, slot->len, crc);
+    uint8_t tail[2] = {static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8)};
+
+    uint16_t n = 0;
+    _txFrame[n++] = HDLC_FLAG;
+    n = hdlcStuff(_txFrame, n, header, headerLen);
+    if (slot)
+        n = hdlcStuff(_txFrame, n, slot->data, slot->len);
+    n = hdlcStuff(_txFrame, n, tail, 2);
+    _txFrame[n++] = HDLC_FLAG;
+
+    // 単独 ACK はデータの後ろに並ばないよう最上位レーンへ
+    uint8_t lane = slot ? 0 : STM32BS_TX_LANES - 1;
+    if (_serial.writable_len(lane) < n)
+        return false;
+    _serial.writeLane(lane, _txFrame, n);
+
+    if (slot)
+        _stats.framesSent++;
+    else
+        _stats.acksSent++;
+    _ackPending = false;
+    return true;
+}
@@ -13,3 +13,10 @@ extern "C" void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart)
         obj->handleTxComplete();
     }
 }
+
+extern "C" void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+    if (auto obj = STM32BufferedSerial::fromHandle(huart)) {
+        obj->handleError();
+    }
+}
@@ -0,0 +1,14 @@
+#include "../Hdlc.hpp"
+
+uint16_t hdlcStuff(uint8_t* dst, uint16_t pos, const uint8_t* src, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t b = src[i];
+        if (b == HDLC_FLAG || b == HDLC_ESC) {
+            dst[pos++] = HDLC_ESC;
+            b ^= HDLC_ESC_XOR;
+        }
+        dst[pos++] = b;
+    }
+    return pos;
+}
@@ -0,0 +1,17 @@
+#ifndef STM32_BUFFERED_SERIAL_IRQ_LOCK_HPP
+#define STM32_BUFFERED_SERIAL_IRQ_LOCK_HPP
+
+#include "stm32f4xx_hal.h"
+
+/** 割り込み禁止区間（PRIMASK を保存・復元するのでネスト可） */
+class IrqLock {
+public:
+    IrqLock() : _primask(__get_PRIMASK()) { __disable_irq(); }
+    ~IrqLock() { if (!_primask) __enable_irq(); }
+    IrqLock(const IrqLock&) = delete;
+    IrqLock& operator=(const IrqLock&) = delete;
+private:
+    uint32_t _primask;
+};
+
+#endif
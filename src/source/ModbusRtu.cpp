@@ -0,0 +1,282 @@
+#include "../ModbusRtu.hpp"
+#include "../Crc16.hpp"
+
+namespace {
+constexpr uint8_t FC_READ_HOLDING = 0x03;
+constexpr uint8_t FC_READ_INPUT = 0x04;
+constexpr uint8_t FC_WRITE_SINGLE = 0x06;
+constexpr uint8_t FC_WRITE_MULTIPLE = 0x10;
+
+constexpr uint8_t EX_ILLEGAL_FUNCTION = 0x01;
+constexpr uint8_t EX_ILLEGAL_ADDRESS = 0x02;
+constexpr uint8_t EX_ILLEGAL_VALUE = 0x03;
+
+constexpr uint16_t MAX_READ_REGS = 125;
+constexpr uint16_t MAX_WRITE_REGS = 123;
+
+inline uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+inline void putBe16(uint8_t* p, uint16_t v) { p[0] = v >> 8; p[1] = v & 0xFF; }
+}
+
+ModbusRtu::ModbusRtu(STM32BufferedSerial& serial)
+    : _serial(serial),
+      _slaveAddr(0), _holding(nullptr), _holdingCount(0),
+      _input(nullptr), _inputCount(0),
+      _status(Status::Idle), _exception(0),
+      _reqSlave(0), _reqFunction(0), _reqAddr(0), _reqCount(0),
+      _reqDst(nullptr), _reqStart(0), _reqTimeout(0),
+      _crcErrors(0), _txErrors(0)
+{
+}
+
+void ModbusRtu::begin()
+{
+    // 3.5 文字 = 8E1/8N2 の 11 ビット × 3.5 ≒ 39 ビット時間
+    _serial.enableIdleDetection(39);
+}
+
+void ModbusRtu::setSlave(uint8_t address, uint16_t* holding, uint16_t holdingCount,
+                         const uint16_t* input, uint16_t inputCount)
+{
+    _slaveAddr = address;
+    _holding = holding;
+    _holdingCount = holding ? holdingCount : 0;
+    _input = input;
+    _inputCount = input ? inputCount : 0;
+}
+
+/*----------------------------------------
+ * 受信処理
+ *----------------------------------------*/
+void ModbusRtu::poll()
+{
+    // アイドルで区切られた完全なフレームだけを取り出す（MAX_FRAME 超は破棄）
+    int len;
+    while ((len = _serial.readFrame(_frame, MAX_FRAME)) > 0) {
+        if (len <= MAX_FRAME)
+            _handleFrame(_frame, static_cast<uint16_t>(len));
+    }
+
+    if (_status == Status::Pending && HAL_GetTick() - _reqStart >= _reqTimeout)
+        _status = Status::Timeout;
+}
+
+void ModbusRtu::_handleFrame(const uint8_t* frame, uint16_t len)
+{
+    if (len < 4) return;
+    uint16_t crc = crc16Modbus(frame, len - 2);
+    if (frame[len - 2] != (crc & 0xFF) || frame[len - 1] != (crc >> 8)) {
+        _crcErrors++;
+        if (_status == Status::Pending && frame[0] == _reqSlave)
+            _status = Status::CrcError;
+        return;
+    }
+
+    if (_status == Status::Pending) {
+        if (frame[0] == _reqSlave) _handleResponse(frame, len - 2);
+    } else if (_slaveAddr && (frame[0] == _slaveAddr || frame[0] == 0)) {
+        _serveRequest(frame, len - 2);
+    }
+}
+
+/*----------------------------------------
+ * スレーブ
+ *----------------------------------------*/
+void ModbusRtu::_serveRequest(const uint8_t* req, uint16_t len)
+{
+    const bool broadcast = (req[0] == 0);
+    const uint8_t fc = req[1];
+    uint8_t resp[MAX_FRAME];
+    resp[0] = _slaveAddr;
+    resp[1] = fc;
+
+    switch (fc) {
+    case FC_READ_HOLDING:
+    case FC_READ_INPUT: {
+        if (broadcast || len != 6) return;
+        uint16_t addr = be16(&req[2]);
+        uint16_t count = be16(&req[4]);
+        const uint16_t* regs = (fc == FC_READ_HOLDING) ? _holding : _input;
+        uint16_t total = (fc == FC_READ_HOLDING) ? _holdingCount : _inputCount;
+        if (count == 0 || count > MAX_READ_REGS) { _sendException(fc, EX_ILLEGAL_VALUE); return; }
+        if (!regs || static_cast<uint32_t>(addr) + count > total) { _sendException(fc, EX_ILLEGAL_ADDRESS); return; }
+        resp[2] = static_cast<uint8_t>(count * 2);
+        for (uint16_t i = 0; i < count; i++) putBe16(&resp[3 + i * 2], regs[addr + i]);
+        _sendFrame(resp, 3 + count * 2);
+        return;
+    }
+    case FC_WRITE_SINGLE: {
+        if (len != 6) return;
+        uint16_t addr = be16(&req[2]);
+        if (!_holding || addr >= _holdingCount) {
+            if (!broadcast) _sendException(fc, EX_ILLEGAL_ADDRESS);
+            return;
+        }
+        _holding[addr] = be16(&req[4]);
+        if (broadcast) return;
+        for (uint8_t i = 2; i < 6; i++) resp[i] = req[i];  // 要求をそのまま返す
+        _sendFrame(resp, 6);
+        return;
+    }
+    case FC_WRITE_MULTIPLE: {
+        if (len < 7) return;
+        uint16_t addr = be16(&req[2]);
+        uint16_t count = be16(&req[4]);
+        if (count == 0 || count > MAX_WRITE_REGS || req[6] != count * 2 || len != 7 + count * 2) {
+            if (!broadcast) _sendException(fc, EX_ILLEGAL_VALUE);
+            return;
+        }
+        if (!_holding || static_cast<uint32_t>(addr) + count > _holdingCount) {
+            if (!broadcast) _sendException(fc, EX_ILLEGAL_ADDRESS);
+            return;
+        }
+        for (uint16_t i = 0; i < count; i++) _holding[addr + i] = be16(&req[7 + i * 2]);
+        if (broadcast) return;
+        for (uint8_t i = 2; i < 6; i++) resp[i] = req[i];
+        _sendFrame(resp, 6);
+        return;
+    }
+    default:
+        if (!broadcast) _sendException(fc, EX_ILLEGAL_FUNCTION);
+        return;
+    }
+}
+
+void ModbusRtu::_sendException(uint8_t function, uint8_t code)
+{
+    uint8_t resp[3];
+    resp[0] = _slaveAddr;
+    resp[1] = function | 0x80;
+    resp[2] = code;
+    _sendFrame(resp, 3);
+}
+
+bool ModbusRtu::_sendFrame(const uint8_t* frame, uint16_t len)
+{
+    uint16_t crc = crc16Modbus(frame, len);
+    uint8_t tail[2] = {static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8)};
+    // 途中までのフレームは相手に CRC エラーとしか見えないので、全部入る時だけキューに入れる
+    const STM32BufferedSerial::IoVec iov[2] = {{frame, len}, {tail, 2}};
+    if (_serial.writev(iov, 2) == 0) {
+        _txErrors++;
+        return false;
+    }
+    return true;
+}
+
+/*----------------------------------------
+ * マスター
+ *----------------------------------------*/
+bool ModbusRtu::_requestRead(uint8_t function, uint8_t slave, uint16_t addr, uint16_t count,
+                             uint16_t* dst, uint32_t timeoutMs)
+{
+    if (_status == Status::Pending || count == 0 || count > MAX_READ_REGS) return false;
+    uint8_t req[6];
+    req[0] = slave;
+    req[1] = function;
+    putBe16(&req[2], addr);
+    putBe16(&req[4], count);
+
+    if (!_sendFrame(req, 6)) return false;
+    _reqSlave = slave;
+    _reqFunction = function;
+    _reqAddr = addr;
+    _reqCount = count;
+    _reqDst = dst;
+    _reqTimeout = timeoutMs;
+    _status = Status::Pending;
+    _reqStart = HAL_GetTick();
+    return true;
+}
+
+bool ModbusRtu::readHoldingRegisters(uint8_t slave, uint16_t addr, uint16_t count,
+                                     uint16_t* dst, uint32_t timeoutMs)
+{
+    return _requestRead(FC_READ_HOLDING, slave, addr, count, dst, timeoutMs);
+}
+
+bool ModbusRtu::readInputRegisters(uint8_t slave, uint16_t addr, uint16_t count,
+                                   uint16_t* dst, uint32_t timeoutMs)
+{
+    return _requestRead(FC_READ_INPUT, slave, addr, count, dst, timeoutMs);
+}
+
+bool ModbusRtu::writeSingleRegister(uint8_t slave, uint16_t addr, uint16_t value,
+                                    uint32_t timeoutMs)
+{
+    if (_status == Status::Pending) return false;
+    uint8_t req[6];
+    req[0] = slave;
+    req[1] = FC_WRITE_SINGLE;
+    putBe16(&req[2], addr);
+    putBe16(&req[4], value);
+
+    if (!_sendFrame(req, 6)) return false;
+    _reqSlave = slave;
+    _reqFunction = FC_WRITE_SINGLE;
+    _reqAddr = addr;
+    _reqCount = 1;
+    _reqDst = nullptr;
+    _reqTimeout = timeoutMs;
+    // ブロードキャストは応答なし
+    _status = slave ? Status::Pending : Status::Ok;
+    _reqStart = HAL_GetTick();
+    return true;
+}
+
+bool ModbusRtu::writeMultipleRegisters(uint8_t slave, uint16_t addr, const uint16_t* src,
+                                       uint16_t count, uint32_t timeoutMs)
+{
+    if (_status == Status::Pending || count == 0 || count > MAX_WRITE_REGS) return false;
+    uint8_t req[MAX_FRAME];
+    req[0] = slave;
+    req[1] = FC_WRITE_MULTIPLE;
+    putBe16(&req[2], addr);
+    putBe16(&req[4], count);
+    req[6] = static_cast<uint8_t>(count * 2);
+    for (uint16_t i = 0; i < count; i++) putBe16(&req[7 + i * 2], src[i]);
+
+    if (!_sendFrame(req, 7 + count * 2)) return false;
+    _reqSlave = slave;
+    _reqFunction = FC_WRITE_MULTIPLE;
+    _reqAddr = addr;
+    _reqCount = count;
+    _reqDst = nullptr;
+    _reqTimeout = timeoutMs;
+    _status = slave ? Status::Pending : Status::Ok;
+    _reqStart = HAL_GetTick();
+    return true;
+}
+
+void ModbusRtu::_handleResponse(const uint8_t* resp, uint16_t len)
+{
+    if (resp[1] == (_reqFunction | 0x80)) {
+        _exception = (len >= 3) ? resp[2] : 0;
+        _status = Status::Exception;
+        return;
+    }
+    if (resp[1] != _reqFunction) {
+        _status = Status::BadResponse;
+        return;
+    }
+
+    switch (_reqFunction) {
+    case FC_READ_HOLDING:
+    case FC_READ_INPUT:
+        if (len != 3 + _reqCount * 2 || resp[2] != _reqCount * 2) {
+            _status = Status::BadResponse;
+            return;
+        }
+        if (_reqDst) {
+            for (uint16_t i = 0; i < _reqCount; i++) _reqDst[i] = be16(&resp[3 + i * 2]);
+        }
+        break;
+    default:
+        if (len != 6 || be16(&resp[2]) != _reqAddr) {
+            _status = Status::BadResponse;
+            return;
+        }
+        break;
+    }
+    _status = Status::Ok;
+}
@@ -1,4 +1,5 @@
 #include "../STM32BufferedSerial.hpp"
+#include "IrqLock.hpp"
 #include <cstring>
 #include <cstdlib>
 
@@ -6,18 +7,59 @@ STM32BufferedSerial* STM32BufferedSerial::instance_table_[MAX_UARTS] = {nullptr}
 
 STM32BufferedSerial::STM32BufferedSerial(UART_HandleTypeDef* huart, uint16_t bufSize)
     : _huart(huart),
-      _rxSize(bufSize),
-      _txSize(bufSize),
+      _rxSize(_rxRingSize(bufSize)), _rxMask(_rxSize - 1),
       _rxHead(0), _rxTail(0),
-      _txHead(0), _txTail(0),
-      _rxTmp(0)
+      _rxTmp(0),
+      _errors{0, 0, 0, 0},
+      _errMarkerEnabled(false),
+      _errMarker(0xFF),
+      _rxDropped(0),
+      _rtsPort(nullptr),
+      _rtsPin(0),
+      _rxThrottled(false),
+      _rxStallStart(0), _rxStallMs(0),
+      _ctsPort(nullptr), _ctsPin(0),
+      _txCtsStalled(false),
+      _txStallStart(0), _txStallMs(0),
+      _txBusy(false), _txChunk(0),
+      _tx{}, _txCur(0), _txSched(TX_SCHED_STRICT), _txRr(0),
+      _txStaging(false), _txExt(false), _txExtOff(0),
+      _xonxoff(false), _txPaused(false),
+      _txCtrl(0), _txCtrlByte(0),
+      _rxIdleCount(0), _rxCount(0),
+      _rxFrameEnds{}, _rxFrameHead(0), _rxFrameTail(0),
+      _rxFramesMerged(0), _rxIdlePending(false),
+      _eventCb(nullptr), _eventCtx(nullptr),
+      _eventMask(0), _eventPending(0),
+      _eventCount(1), _eventDelimiter('\n'),
+      _eventDeferred(false), _eventIrq(PendSV_IRQn),
+      _rs485(false), _rs485Cfg{nullptr, 0, 0, 0, false},
+      _deAsserted(false)
 {
     _rxBuf = new uint8_t[_rxSize];
-    _txBuf = new uint8_t[_txSize];
+    for (int i = 0; i < STM32BS_TX_LANES; i++) {
+        _tx[i].size = (i == 0) ? bufSize : STM32BS_TX_LANE_SIZE;
+        _tx[i].buf = new uint8_t[_tx[i].size];
+        _tx[i].weight = 64;
+    }
+
+    // 既定の閾値: 空き STM32BS_RX_THROTTLE_MARGIN バイトで停止、半分で再開
+    if (_rxSize > 2 * STM32BS_RX_THROTTLE_MARGIN)
+        _rxHighWater = _rxSize - 1 - STM32BS_RX_THROTTLE_MARGIN;
+    else
+        _rxHighWater = _rxSize * 3 / 4;
+    _rxLowWater = _rxSize / 2;
 
     registerInstance(_huart, this);
 }
 
+uint16_t STM32BufferedSerial::_rxRingSize(uint16_t bufSize) {
+    // インデックス計算を剰余ではなくマスクにするため 2 のべき乗に切り上げる
+    uint16_t size = 2;
+    while (size < bufSize && size < 0x8000u) size <<= 1;
+    return size;
+}
+
 void STM32BufferedSerial::begin() {
     _startRxInterrupt();
 }
@@ -27,101 +69,953 @@ void STM32BufferedSerial::begin() {
  *----------------------------------------*/
 void STM32BufferedSerial::handleRxComplete()
 {
-    uint16_t next = (_rxHead + 1) % _rxSize;
-    if (next != _rxTail) { // バッファに空きがあれば格納
-        _rxBuf[_rxHead] = _rxTmp;
-        _rxHead = next;
+    // 誤りのあるバイトは続く handleError() がマーカーを入れてから区切る
+    // （受信の再開で ErrorCode が消えるので先に見ておく）
+    bool clean = _huart->ErrorCode == HAL_UART_ERROR_NONE;
+    _receive(_rxTmp);
+    _startRxInterrupt();
+    if (_rxIdlePending && clean) {
+        _rxIdlePending = false;
+        _endRxBurst();
     }
+}
 
-    // 🔥 再受信を確実に開始する（HAL_BUSY対策付き）
-    if (HAL_UART_Receive_IT(_huart, &_rxTmp, 1) != HAL_OK)
+void STM32BufferedSerial::_receive(uint8_t c)
+{
+    // XON(0x11)/XOFF(0x13) は bit1 のみ異なるので 1 回の比較で判定
+    if (_xonxoff && (c & 0xFD) == XON) {
+        if (c == XOFF) {
+            _txPaused = true;
+            _truncateTx();       // 送信中のチャンクも直ちに止める
+        } else {
+            _txPaused = false;
+            _startTxInterrupt();
+        }
+    } else {
+        push(c);
+    }
+}
+
+/*----------------------------------------
+ * エラー割り込みハンドラ
+ *----------------------------------------*/
+void STM32BufferedSerial::handleError()
+{
+    uint32_t err = _huart->ErrorCode;
+    if (err & HAL_UART_ERROR_ORE) _errors.overrun++;
+    if (err & HAL_UART_ERROR_FE)  _errors.framing++;
+    if (err & HAL_UART_ERROR_NE)  _errors.noise++;
+    if (err & HAL_UART_ERROR_PE)  _errors.parity++;
+
+#if defined(USART_ICR_ORECF)
+    // ICR への書き込みでクリアでき、RDR は読まない
+    __HAL_UART_CLEAR_OREFLAG(_huart);
+#else
+    // F4 は SR → DR の読み出しでしかクリアできない。フラグは通常 HAL が DR を読んだ時点で
+    // 消えているので、ORE が残っている時だけ読む（無条件に読むと、その後に届いた正常な
+    // バイトを捨ててしまう）。DR にあるのは取りこぼす前の正しいバイトなので受信として扱う
+    if (__HAL_UART_GET_FLAG(_huart, UART_FLAG_ORE)) {
+        bool full = __HAL_UART_GET_FLAG(_huart, UART_FLAG_RXNE);
+        uint8_t c = static_cast<uint8_t>(_huart->Instance->DR);
+        if (full)
+            _receive(c);
+    }
+#endif
+    _huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+    if (_errMarkerEnabled && err != HAL_UART_ERROR_NONE)
+        push(_errMarker);
+
+    if (_rxIdlePending) {
+        _rxIdlePending = false;
+        _endRxBurst();
+    }
+
+    // ORE などで HAL が受信を中断した場合はこの ISR 内で再開する
+    // （FE/NE/PE のみの場合 HAL は受信を継続しているので何もしない）
+    if (_huart->RxState == HAL_UART_STATE_READY)
+        _startRxInterrupt();
+}
+
+void STM32BufferedSerial::clearErrorCounters()
+{
+    _errors = ErrorCounters{0, 0, 0, 0};
+}
+
+void STM32BufferedSerial::setErrorMarker(bool enable, uint8_t marker)
+{
+    _errMarker = marker;
+    _errMarkerEnabled = enable;
+}
+
+
+/*----------------------------------------
+ * アイドル検出（IDLE / 受信タイムアウト）
+ *----------------------------------------*/
+void STM32BufferedSerial::enableIdleDetection(uint32_t timeoutBits)
+{
+#if defined(USART_CR2_RTOEN)
+    if (timeoutBits) {
+        // 受信タイムアウト: 最後のストップビットから timeoutBits ビット無信号で RTOF
+        HAL_UART_ReceiverTimeout_Config(_huart, timeoutBits);
+        HAL_UART_EnableReceiverTimeout(_huart);
+        __HAL_UART_ENABLE_IT(_huart, UART_IT_RTO);
+        return;
+    }
+#else
+    (void)timeoutBits;  // F4 の USART は受信タイムアウト非対応: IDLE（1 文字分）で代用
+#endif
+    __HAL_UART_CLEAR_IDLEFLAG(_huart);
+    __HAL_UART_ENABLE_IT(_huart, UART_IT_IDLE);
+}
+
+void STM32BufferedSerial::handleIrq()
+{
+#if defined(USART_CR2_RTOEN)
+    if (__HAL_UART_GET_FLAG(_huart, UART_FLAG_RTOF)) {
+        __HAL_UART_CLEAR_FLAG(_huart, UART_CLEAR_RTOF);
+        _rxIdleCount = _rxIdleCount + 1;
+        _endRxBurst();
+    }
+#endif
+    if ((_huart->Instance->CR1 & USART_CR1_IDLEIE) && __HAL_UART_GET_FLAG(_huart, UART_FLAG_IDLE)) {
+        _rxIdleCount = _rxIdleCount + 1;
+        if (__HAL_UART_GET_FLAG(_huart, UART_FLAG_RXNE)) {
+            // 割り込みが遅れて最後のバイトがまだ DR にある。IDLE は続く HAL の DR 読み出しで
+            // クリアされるので、そのバイトがリングに入った後（handleRxComplete）で区切る
+            _rxIdlePending = true;
+        } else {
+            __HAL_UART_CLEAR_IDLEFLAG(_huart);
+            _endRxBurst();
+        }
+    }
+}
+
+void STM32BufferedSerial::_endRxBurst()
+{
+    _markFrameEnd();
+    _raiseEvents(EVENT_RX_IDLE);
+}
+
+void STM32BufferedSerial::_markFrameEnd()
+{
+    uint32_t end = _rxCount;
+    uint8_t head = _rxFrameHead;
+    uint8_t last = (head + STM32BS_RX_FRAME_QUEUE - 1) % STM32BS_RX_FRAME_QUEUE;
+    if (head != _rxFrameTail && _rxFrameEnds[last] == end) return;  // 空のバースト
+
+    uint8_t next = (head + 1) % STM32BS_RX_FRAME_QUEUE;
+    if (next == _rxFrameTail) {
+        // キュー満杯: 直前のバーストと結合する
+        _rxFrameEnds[last] = end;
+        _rxFramesMerged = _rxFramesMerged + 1;
+        return;
+    }
+    _rxFrameEnds[head] = end;
+    _rxFrameHead = next;
+}
+
+uint8_t STM32BufferedSerial::_firstLiveFrame() const
+{
+    // read() などで読み出し済みの区切りは飛ばす
+    uint32_t consumed = _rxCount - readable_len();
+    uint8_t idx = _rxFrameTail;
+    while (idx != _rxFrameHead && static_cast<int32_t>(_rxFrameEnds[idx] - consumed) <= 0)
+        idx = (idx + 1) % STM32BS_RX_FRAME_QUEUE;
+    return idx;
+}
+
+int STM32BufferedSerial::nextFrameLength() const
+{
+    IrqLock lock;
+    uint8_t idx = _firstLiveFrame();
+    if (idx == _rxFrameHead) return 0;
+    return static_cast<int>(_rxFrameEnds[idx] - (_rxCount - readable_len()));
+}
+
+int STM32BufferedSerial::readFrame(uint8_t* dst, uint16_t max)
+{
+    uint32_t len;
     {
-        // 再試行が必要な場合は小delayを入れて再実行（またはErrorHandler）
-        __HAL_UNLOCK(_huart);
-        HAL_UART_AbortReceive(_huart);  // 念のため前回の受信をリセット
-        HAL_UART_Receive_IT(_huart, &_rxTmp, 1);
+        IrqLock lock;
+        uint8_t idx = _firstLiveFrame();
+        if (idx == _rxFrameHead) {
+            _rxFrameTail = idx;
+            return 0;
+        }
+        len = _rxFrameEnds[idx] - (_rxCount - readable_len());
+        _rxFrameTail = (idx + 1) % STM32BS_RX_FRAME_QUEUE;
     }
+
+    uint16_t copied = static_cast<uint16_t>(read(dst, len < max ? len : max));
+    // 収まらなかった残りは捨てる
+    for (uint32_t i = copied; i < len; i++) read();
+    return static_cast<int>(len);
+}
+
+/*----------------------------------------
+ * イベント通知
+ *----------------------------------------*/
+void STM32BufferedSerial::setEventCallback(EventCallback cb, void* context, uint32_t mask)
+{
+    IrqLock lock;
+    _eventCb = cb;
+    _eventCtx = context;
+    _eventPending = 0;
+    _eventMask = cb ? mask : 0;
+}
+
+void STM32BufferedSerial::setEventDeferral(bool enable, IRQn_Type irq)
+{
+    IrqLock lock;
+    _eventIrq = irq;
+    _eventDeferred = enable;
 }
 
+void STM32BufferedSerial::_raiseEvents(uint32_t events)
+{
+    events &= _eventMask;
+    if (!events) return;
+
+    if (!_eventDeferred) {
+        _eventCb(*this, events, _eventCtx);
+        return;
+    }
+    {
+        IrqLock lock;
+        _eventPending = _eventPending | events;
+    }
+    if (_eventIrq == PendSV_IRQn)
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    else
+        NVIC_SetPendingIRQ(_eventIrq);
+}
+
+void STM32BufferedSerial::dispatchEvents()
+{
+    uint32_t events;
+    {
+        IrqLock lock;
+        events = _eventPending;
+        _eventPending = 0;
+    }
+    if (events && _eventCb)
+        _eventCb(*this, events, _eventCtx);
+}
 
 /*----------------------------------------
  * 送信割り込み完了ハンドラ
  *----------------------------------------*/
 void STM32BufferedSerial::handleTxComplete() {
-    if (_txTail != _txHead) {
-        uint8_t data = _txBuf[_txTail];
-        _txTail = (_txTail + 1) % _txSize;
-        HAL_UART_Transmit_IT(_huart, &data, 1);
+    // 送信済みチャンク分だけ読み出し位置を進めて次のチャンクを開始
+    uint16_t sent = _txChunk;
+    _txChunk = 0;
+    _txBusy = false;
+    if (_txExt) _txExtAdvance(sent);
+    else _txAdvance(_txCur, sent);
+    _startTxInterrupt();
+    _raiseEvents(EVENT_TX_DONE);
+
+    // 送信するものがなければ TC 割り込み内でバスを解放
+    if (_rs485 && !_txBusy)
+        _releaseBus();
+}
+
+/*----------------------------------------
+ * 送信中チャンクの打ち切り
+ *----------------------------------------*/
+void STM32BufferedSerial::_truncateTx() {
+    IrqLock lock;
+    if (!_txBusy || _txChunk == 0) return;  // 制御文字の送信は打ち切らない
+    // DR に書き込み済みのバイトは送出されるので送信済みとして扱う
+    uint16_t left = (_txExt && _huart->hdmatx && !_ctsPort)
+        ? static_cast<uint16_t>(__HAL_DMA_GET_COUNTER(_huart->hdmatx))
+        : _huart->TxXferCount;
+    uint16_t sent = _txChunk - left;
+    HAL_UART_AbortTransmit(_huart);
+    _txChunk = 0;
+    _txBusy = false;
+    if (_txExt) _txExtAdvance(sent);
+    else _txAdvance(_txCur, sent);
+}
+
+void STM32BufferedSerial::_txAdvance(uint8_t lane, uint16_t sent) {
+    TxLane& q = _tx[lane];
+    q.tail = (q.tail + sent) % q.size;
+    q.sent = q.sent + sent;
+
+    // 最後のバイトまで送信し終えたフレームを取り出し、コールバックがあれば呼ぶ
+    while (q.markTail != q.markHead) {
+        const TxMarker& m = q.markers[q.markTail];
+        if (static_cast<int32_t>(q.sent - m.end) < 0) break;
+        if (m.ext) break;        // 外部バッファの送信完了は _txExtAdvance() で扱う
+        TxDoneCallback cb = m.cb;
+        void* ctx = m.ctx;
+        q.frameStart = m.end;
+        q.markTail = (q.markTail + 1) % STM32BS_TX_MARKERS;
+        if (cb) cb(*this, ctx);
+    }
+    // 区切りのないデータはレーンが空になった時点でフレーム終端とみなす
+    if (q.tail == q.head) q.frameStart = q.sent;
+}
+
+void STM32BufferedSerial::_txExtAdvance(uint16_t sent) {
+    TxLane& q = _tx[_txCur];
+    _txExt = false;
+    _txExtOff += sent;
+    const TxMarker& m = q.markers[q.markTail];
+    if (_txExtOff < m.extLen) return;   // 残りは次のチャンクで送る
+
+    TxDoneCallback cb = m.cb;
+    void* ctx = m.ctx;
+    _txExtOff = 0;
+    q.frameStart = q.sent;
+    q.markTail = (q.markTail + 1) % STM32BS_TX_MARKERS;
+    _txAdvance(_txCur, 0);   // 続くリング上のフレーム境界を処理
+    if (cb) cb(*this, ctx);
+}
+
+void STM32BufferedSerial::_startTxExt(const TxMarker& m) {
+    // DMA の転送数は 16 ビットなので 65535 バイトごとに区切る（GPIO CTS 使用時は 1 バイトずつ）
+    uint32_t left = m.extLen - _txExtOff;
+    uint16_t chunk = (left > 0xFFFFu) ? 0xFFFFu : static_cast<uint16_t>(left);
+    if (_ctsPort) chunk = 1;
+    uint8_t* p = const_cast<uint8_t*>(m.ext + _txExtOff);
+
+    _txExt = true;
+    _txChunk = chunk;
+    _txBusy = true;
+    if (_rs485) _acquireBus();
+    HAL_StatusTypeDef st = (_huart->hdmatx && !_ctsPort)
+        ? HAL_UART_Transmit_DMA(_huart, p, chunk)
+        : HAL_UART_Transmit_IT(_huart, p, chunk);
+    if (st != HAL_OK) {
+        _txExt = false;
+        _txChunk = 0;
+        _txBusy = false;
+    }
+}
+
+bool STM32BufferedSerial::sendBuffer(const uint8_t* data, uint32_t len, TxDoneCallback done, void* context) {
+    if (len == 0) return false;
+    TxLane& q = _tx[0];
+    {
+        IrqLock lock;
+        // リング上の現在の末尾に外部バッファを挿入する（前後の write() との順序を保つ）
+        uint8_t next = (q.markHead + 1) % STM32BS_TX_MARKERS;
+        if (next == q.markTail) return false;
+        q.markers[q.markHead] = TxMarker{q.queued, done, context, data, len};
+        q.markHead = next;
+    }
+    if (!_txBusy)
+        _startTxInterrupt();
+    return true;
+}
+
+bool STM32BufferedSerial::_txPending(const TxLane& q) {
+    // リングが空でも先頭に外部バッファが残っていれば送信待ち
+    return q.tail != q.head
+        || (q.markTail != q.markHead && q.markers[q.markTail].ext);
+}
+
+uint32_t STM32BufferedSerial::_txFrameLen(const TxLane& q) {
+    if (q.markTail == q.markHead)
+        return static_cast<uint32_t>((q.head + q.size - q.tail) % q.size);
+    const TxMarker& m = q.markers[q.markTail];
+    if (m.ext && m.end == q.sent) return m.extLen;
+    return m.end - q.sent;
+}
+
+/*----------------------------------------
+ * 送信レーンの選択
+ *----------------------------------------*/
+int STM32BufferedSerial::_txPickLane() {
+    // フレームの途中なら同じレーンを続ける（異なるレーンのフレームを混ぜない）
+    const TxLane& cur = _tx[_txCur];
+    if (_txExtOff != 0) return _txCur;
+    if (cur.sent != cur.frameStart && cur.tail != cur.head) return _txCur;
+
+    if (_txSched == TX_SCHED_STRICT) {
+        for (int i = STM32BS_TX_LANES - 1; i >= 0; i--) {
+            if (_txPending(_tx[i])) return i;
+        }
+        return -1;
+    }
+
+    // Deficit round robin。クレジットが足りるまでの巡回数をレーンごとに求め、
+    // 最小のレーンを選ぶ（巡回をループで回さないので大きなフレームでも ISR 時間が一定）
+    int best = -1;
+    uint32_t bestRounds = 0;
+    for (int k = 0; k < STM32BS_TX_LANES; k++) {
+        int i = (_txRr + k) % STM32BS_TX_LANES;
+        TxLane& q = _tx[i];
+        if (!_txPending(q)) {
+            q.deficit = 0;
+            continue;
+        }
+        uint32_t frame = _txFrameLen(q);
+        uint32_t rounds = (q.deficit >= static_cast<int32_t>(frame))
+            ? 0 : (frame - q.deficit + q.weight - 1) / q.weight;
+        if (best < 0 || rounds < bestRounds) {
+            best = i;
+            bestRounds = rounds;
+        }
+    }
+    if (best < 0) return -1;
+    if (bestRounds) {
+        for (int i = 0; i < STM32BS_TX_LANES; i++) {
+            if (_txPending(_tx[i])) _tx[i].deficit += bestRounds * _tx[i].weight;
+        }
     }
+    _tx[best].deficit -= _txFrameLen(_tx[best]);
+    _txRr = static_cast<uint8_t>(best);
+    return best;
+}
+
+void STM32BufferedSerial::setTxScheduling(TxScheduling mode) {
+    IrqLock lock;
+    _txSched = mode;
+}
+
+void STM32BufferedSerial::setTxLaneWeight(uint8_t lane, uint16_t weight) {
+    if (lane >= STM32BS_TX_LANES) return;
+    IrqLock lock;
+    _tx[lane].weight = weight ? weight : 1;
 }
 
 /*----------------------------------------
  * 受信割り込み開始
  *----------------------------------------*/
 void STM32BufferedSerial::_startRxInterrupt() {
-    HAL_UART_Receive_IT(_huart, &_rxTmp, 1);
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_THROTTLE
+    // ハードウェア RTS: 受信を再開しなければ RXNE が立ったままになり RTS が自動でデアサートされる
+    if (_rxThrottled && (_huart->Init.HwFlowCtl & UART_HWCONTROL_RTS)) return;
+#endif
+    // 🔥 再受信を確実に開始する（HAL_BUSY対策付き）
+    if (HAL_UART_Receive_IT(_huart, &_rxTmp, 1) != HAL_OK)
+    {
+        __HAL_UNLOCK(_huart);
+        HAL_UART_AbortReceive(_huart);  // 念のため前回の受信をリセット
+        HAL_UART_Receive_IT(_huart, &_rxTmp, 1);
+    }
 }
 
 /*----------------------------------------
  * 送信割り込み開始
  *----------------------------------------*/
 void STM32BufferedSerial::_startTxInterrupt() {
-    if (_txTail == _txHead) return;   // バッファ空
-    uint8_t data = _txBuf[_txTail];
-    _txTail = (_txTail + 1) % _txSize;
-    HAL_UART_Transmit_IT(_huart, &data, 1);
+    // RS-485（GPIO DE）: バスを取る際のアサート時間は割り込みを許可したまま待つ
+    if (_rs485 && _rs485Cfg.dePort && _rs485Cfg.assertTime && !_deAsserted) {
+        {
+            IrqLock lock;
+            if (_txBusy || _deAsserted) return;
+            if (!_txCtrl && (_txPaused || !_txAnyPending())) return;
+            // _txChunk = 0 の送信中扱いで送信権を確保（打ち切り・flushTx() の対象外）
+            _txChunk = 0;
+            _txBusy = true;
+            _acquireBus();
+        }
+        _waitSampleTimes(_rs485Cfg.assertTime);
+        {
+            IrqLock lock;
+            _txBusy = false;
+            _startTxNext();
+        }
+        // 待っている間に送るものが無くなった（flushTx() など）
+        if (!_txBusy)
+            _releaseBus();
+        return;
+    }
+    IrqLock lock;
+    _startTxNext();
+}
+
+bool STM32BufferedSerial::_txAnyPending() const {
+    for (int i = 0; i < STM32BS_TX_LANES; i++) {
+        if (_txPending(_tx[i])) return true;
+    }
+    return false;
+}
+
+void STM32BufferedSerial::_startTxNext() {
+    if (_txBusy) return;              // 送信中（完了割り込みで続きを送る）
+
+    // XON/XOFF はキュー内のデータより先に送る
+    if (_txCtrl) {
+        _txCtrlByte = _txCtrl;
+        _txCtrl = 0;
+        _txChunk = 0;
+        _txBusy = true;
+        if (_rs485) _acquireBus();
+        if (HAL_UART_Transmit_IT(_huart, &_txCtrlByte, 1) != HAL_OK) {
+            _txCtrl = _txCtrlByte;
+            _txBusy = false;
+        }
+        return;
+    }
+    if (_txPaused) return;            // XOFF 受信中
+    if (!_txAnyPending()) return;     // バッファ空
+
+    // CTS（GPIO）がデアサートされていれば handleCtsChange() まで待つ
+    if (_ctsPort && HAL_GPIO_ReadPin(_ctsPort, _ctsPin) == GPIO_PIN_SET) {
+        if (!_txCtsStalled) {
+            _txCtsStalled = true;
+            _txStallStart = HAL_GetTick();
+        }
+        return;
+    }
+
+    int lane = _txPickLane();
+    TxLane& q = _tx[lane];
+    _txCur = static_cast<uint8_t>(lane);
+
+    // 外部バッファの位置に達していれば呼び出し元のメモリから直接送る
+    if (q.markTail != q.markHead) {
+        const TxMarker& m = q.markers[q.markTail];
+        if (m.ext && m.end == q.sent) {
+            _startTxExt(m);
+            return;
+        }
+    }
+
+    uint16_t head = q.head;
+    uint16_t tail = q.tail;
+
+    // リングバッファ上の連続領域をまとめて送信（GPIO CTS 使用時は 1 バイトずつ確認）
+    uint16_t chunk = (head > tail) ? (head - tail) : (q.size - tail);
+    if (_ctsPort) chunk = 1;
+
+    // 完了通知・外部バッファの位置でチャンクを区切る。レーンが複数あるときは常に先頭フレームの
+    // 末尾で区切る（送信中に他レーンへ書かれたフレームも、今送っているフレームの後に割り込める）
+    for (uint8_t i = q.markTail; i != q.markHead; i = (i + 1) % STM32BS_TX_MARKERS) {
+        const TxMarker& m = q.markers[i];
+        if (m.cb || m.ext || (STM32BS_TX_LANES > 1 && i == q.markTail)) {
+            uint32_t toEnd = m.end - q.sent;
+            if (toEnd < chunk) chunk = static_cast<uint16_t>(toEnd);
+            break;
+        }
+    }
+
+    _txChunk = chunk;
+    _txBusy = true;
+    if (_rs485) _acquireBus();
+    if (HAL_UART_Transmit_IT(_huart, &q.buf[tail], chunk) != HAL_OK) {
+        _txChunk = 0;
+        _txBusy = false;
+    }
 }
 
 /*----------------------------------------
  * データ読み取り
  *----------------------------------------*/
 int STM32BufferedSerial::read() {
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+    // ISR も _rxTail を進めるため LDREX/STREX で更新する。
+    // 例外の出入りで排他モニタがクリアされるので、途中で ISR が割り込んだ場合は再試行になる
+    uint16_t tail;
+    uint8_t data;
+    do {
+        tail = __LDREXH(&_rxTail);
+        if (tail == _rxHead) {   // データなし
+            __CLREX();
+            return -1;
+        }
+        data = _rxBuf[tail];
+    } while (__STREXH(static_cast<uint16_t>((tail + 1) & _rxMask), &_rxTail) != 0);
+#else
     if (_rxTail == _rxHead) return -1;  // データなし
     uint8_t data = _rxBuf[_rxTail];
-    _rxTail = (_rxTail + 1) % _rxSize;
+    _rxTail = (_rxTail + 1) & _rxMask;
+#endif
+
+    _checkRxRelease();
     return data;
 }
 
+int STM32BufferedSerial::read(uint8_t* dst, uint16_t len) {
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+    IrqLock lock;  // ISR も _rxTail を進めるのでコピー中は割り込み禁止
+#endif
+    uint16_t tail = _rxTail;
+    uint16_t avail = static_cast<uint16_t>(readable_len());
+    if (len > avail) len = avail;
+    if (len == 0) return 0;
+
+    // 折り返しを考慮して最大 2 回の memcpy でコピー
+    uint16_t first = _rxSize - tail;
+    if (first > len) first = len;
+    memcpy(dst, &_rxBuf[tail], first);
+    if (len > first) memcpy(dst + first, &_rxBuf[0], len - first);
+    _rxTail = (tail + len) & _rxMask;
+
+    _checkRxRelease();
+    return len;
+}
+
+int STM32BufferedSerial::peek(uint16_t offset) const {
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+    IrqLock lock;  // 読み出し位置を ISR が進める可能性がある
+#endif
+    uint16_t tail = _rxTail;
+    if (offset >= ((_rxHead - tail) & _rxMask)) return -1;
+    return _rxBuf[(tail + offset) & _rxMask];
+}
+
+STM32BufferedSerial::PeekView STM32BufferedSerial::peekView() const {
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+    IrqLock lock;
+#endif
+    uint16_t tail = _rxTail;
+    return PeekView(_rxBuf, _rxMask, tail, static_cast<uint16_t>((_rxHead - tail) & _rxMask));
+}
+
+const uint8_t* STM32BufferedSerial::rxPeekContiguous(uint16_t& len) const {
+    uint16_t tail = _rxTail;
+    uint16_t avail = static_cast<uint16_t>(readable_len());
+    uint16_t first = _rxSize - tail;
+    len = (avail < first) ? avail : first;
+    return &_rxBuf[tail];
+}
+
+void STM32BufferedSerial::rxConsume(uint16_t len) {
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+    IrqLock lock;
+#endif
+    uint16_t avail = static_cast<uint16_t>(readable_len());
+    if (len > avail) len = avail;
+    _rxTail = (_rxTail + len) & _rxMask;
+    _checkRxRelease();
+}
+
+void STM32BufferedSerial::_checkRxRelease() {
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_THROTTLE
+    // 下側閾値まで空いたら送信側を再開
+    if (_rxThrottled && readable_len() <= _rxLowWater)
+        _setRxThrottle(false);
+#endif
+}
+
 /*----------------------------------------
  * データ送信
  *----------------------------------------*/
 int STM32BufferedSerial::write(uint8_t data) {
-    uint16_t next = (_txHead + 1) % _txSize;
-    if (next == _txTail) return -1;  // バッファ満杯
+    return (writeLane(0, &data, 1) == 1) ? 1 : -1;  // -1: バッファ満杯
+}
 
-    _txBuf[_txHead] = data;
-    _txHead = next;
+int STM32BufferedSerial::write(const uint8_t* data, uint16_t len) {
+    return writeLane(0, data, len);
+}
+
+int STM32BufferedSerial::write(const uint8_t* data, uint16_t len, TxDoneCallback done, void* context) {
+    if (!done) return 0;
+    return writeLane(0, data, len, done, context);
+}
 
-    if (_huart->gState == HAL_UART_STATE_READY)
+uint8_t* STM32BufferedSerial::txReserve(uint16_t& len) {
+    len = 0;
+    TxStage st;
+    if (!_stageBegin(st)) return nullptr;
+    // 折り返し位置までの連続領域だけを渡す
+    uint16_t first = st.size - st.pos;
+    len = (st.left < first) ? st.left : first;
+    if (len == 0) {
+        _stageCommit(st);   // 空きなし: 予約を解除
+        return nullptr;
+    }
+    return &st.buf[st.pos];
+}
+
+void STM32BufferedSerial::txCommit(uint16_t len) {
+    if (!_txStaging) return;
+    TxLane& q = _tx[0];
+    uint16_t first = q.size - q.head;
+    uint16_t free = _txFree(q);
+    if (len > first) len = first;
+    if (len > free) len = free;
+    _stageCommit(TxStage{q.buf, q.size, static_cast<uint16_t>((q.head + len) % q.size), 0, len});
+}
+
+int STM32BufferedSerial::writeLane(uint8_t lane, const uint8_t* data, uint16_t len,
+                                   TxDoneCallback done, void* context) {
+    if (lane >= STM32BS_TX_LANES || len == 0) return 0;
+    TxLane& q = _tx[lane];
+    {
+        IrqLock lock;
+        if (lane == 0 && _txStaging) return 0;   // printf() が空き領域に書き込み中
+        uint16_t space = _txFree(q);
+        if (done) {
+            // 完了通知付きは全部入るときだけ受け付ける
+            uint8_t next = (q.markHead + 1) % STM32BS_TX_MARKERS;
+            if (next == q.markTail || space < len) return 0;
+        } else if (len > space) {
+            len = space;
+            if (len == 0) return 0;
+        }
+        _txEnqueue(q, data, len);
+        _txMark(q, done, context);
+    }
+    if (!_txBusy)
         _startTxInterrupt();
+    return len;
+}
+
+int STM32BufferedSerial::writev(const IoVec* iov, uint8_t count, uint8_t lane,
+                                TxDoneCallback done, void* context) {
+    if (lane >= STM32BS_TX_LANES) return 0;
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < count; i++) total += iov[i].len;
+    if (total == 0) return 0;
 
-    return 1;
+    TxLane& q = _tx[lane];
+    {
+        IrqLock lock;
+        // 空き確認は 1 回だけ。全セグメントが入らなければ何もしない
+        uint8_t next = (q.markHead + 1) % STM32BS_TX_MARKERS;
+        if (lane == 0 && _txStaging) return 0;
+        if (total > _txFree(q) || (done && next == q.markTail)) return 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (iov[i].len) _txEnqueue(q, iov[i].data, iov[i].len);
+        }
+        _txMark(q, done, context);
+    }
+    if (!_txBusy)
+        _startTxInterrupt();
+    return static_cast<int>(total);
 }
 
-int STM32BufferedSerial::write(const uint8_t* data, uint16_t len) {
-    int written = 0;
-    for (uint16_t i = 0; i < len; i++) {
-        if (write(data[i]) == 1) written++;
-        else break;
+int STM32BufferedSerial::writable_len(uint8_t lane) const {
+    if (lane >= STM32BS_TX_LANES) return 0;
+    return _txFree(_tx[lane]);
+}
+
+uint16_t STM32BufferedSerial::_txFree(const TxLane& q) {
+    uint16_t head = q.head;
+    uint16_t tail = q.tail;
+    uint16_t used = (head >= tail) ? (head - tail) : (q.size - (tail - head));
+    return q.size - 1 - used;
+}
+
+void STM32BufferedSerial::_txEnqueue(TxLane& q, const uint8_t* data, uint16_t len) {
+    // 折り返しを考慮して最大 2 回の memcpy でコピーしてから書き込み位置を公開
+    uint16_t head = q.head;
+    uint16_t first = q.size - head;
+    if (first > len) first = len;
+    memcpy(&q.buf[head], data, first);
+    if (len > first) memcpy(&q.buf[0], data + first, len - first);
+    q.queued += len;
+    q.head = (head + len) % q.size;
+}
+
+bool STM32BufferedSerial::_txMark(TxLane& q, TxDoneCallback cb, void* ctx) {
+    uint8_t next = (q.markHead + 1) % STM32BS_TX_MARKERS;
+    if (next == q.markTail) {
+        // キュー満杯: 直前の区切りが通知なしなら延長して結合する
+        uint8_t last = (q.markHead + STM32BS_TX_MARKERS - 1) % STM32BS_TX_MARKERS;
+        if (!cb && !q.markers[last].cb && !q.markers[last].ext) {
+            q.markers[last].end = q.queued;
+            return true;
+        }
+        return false;
     }
-    return written;
+    q.markers[q.markHead] = TxMarker{q.queued, cb, ctx, nullptr, 0};
+    q.markHead = next;
+    return true;
 }
 
 void STM32BufferedSerial::push(uint8_t c)
 {
-    uint16_t next = (_rxHead + 1) % _rxSize;
-    if (next != _rxTail) {          // バッファ満杯でなければ
-        _rxBuf[_rxHead] = c;
-        _rxHead = next;
+    uint16_t next = (_rxHead + 1) & _rxMask;
+    if (next == _rxTail) {          // バッファ満杯
+        _rxDropped = _rxDropped + 1;
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+        // 最古のバイトを捨てて最新データを残す（read() 側の STREX は失敗して再試行される）
+        _rxTail = (_rxTail + 1) & _rxMask;
+#else
+        return;
+#endif
     }
+    _rxBuf[_rxHead] = c;
+    _rxHead = next;
+    _rxCount = _rxCount + 1;
+
+    if (_eventMask) {
+        uint32_t events = EVENT_RX_DATA;
+        uint16_t fill = static_cast<uint16_t>(readable_len());
+        if (fill == _eventCount) events |= EVENT_RX_COUNT;
+        if (c == _eventDelimiter) events |= EVENT_RX_DELIMITER;
+        if (fill == _rxHighWater) events |= EVENT_RX_WATERMARK;
+        _raiseEvents(events);
+    }
+
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_THROTTLE
+    // 上側閾値に達したら送信側を停止
+    if (!_rxThrottled && readable_len() >= _rxHighWater)
+        _setRxThrottle(true);
+#endif
 }
 
 int STM32BufferedSerial::pop()
 {
-    if (_rxHead == _rxTail) return -1;  // データなし
-    uint8_t val = _rxBuf[_rxTail];
-    _rxTail = (_rxTail + 1) % _rxSize;
-    return val;
+    return read();
+}
+
+/*----------------------------------------
+ * フロー制御（RTS）
+ *----------------------------------------*/
+void STM32BufferedSerial::setRtsPin(GPIO_TypeDef* port, uint16_t pin)
+{
+    _rtsPort = port;
+    _rtsPin = pin;
+    if (_rtsPort)
+        HAL_GPIO_WritePin(_rtsPort, _rtsPin, _rxThrottled ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+void STM32BufferedSerial::setRxWatermarks(uint16_t high, uint16_t low)
+{
+    if (high >= _rxSize) high = _rxSize - 1;
+    if (low >= high) low = high - 1;
+    _rxHighWater = high;
+    _rxLowWater = low;
+}
+
+void STM32BufferedSerial::_setRxThrottle(bool throttle)
+{
+    {
+        IrqLock lock;
+        if (_rxThrottled == throttle) return;
+        _rxThrottled = throttle;
+        if (throttle) {
+            _rxStallStart = HAL_GetTick();
+        } else {
+            _rxStallMs = _rxStallMs + (HAL_GetTick() - _rxStallStart);
+        }
+        // RTS はアクティブ Low: High で送信停止要求
+        if (_rtsPort)
+            HAL_GPIO_WritePin(_rtsPort, _rtsPin, throttle ? GPIO_PIN_SET : GPIO_PIN_RESET);
+
+        // XOFF/XON を送信待ちデータに割り込ませて送る
+        if (_xonxoff) {
+            _txCtrl = throttle ? XOFF : XON;
+            _truncateTx();
+        }
+    }
+    if (_xonxoff)
+        _startTxInterrupt();
+
+    // ハードウェア RTS の場合は停止中に保留していた受信を再開
+    if (!throttle && (_huart->Init.HwFlowCtl & UART_HWCONTROL_RTS)
+        && _huart->RxState == HAL_UART_STATE_READY)
+        _startRxInterrupt();
+}
+
+uint32_t STM32BufferedSerial::getRxStallMs() const
+{
+    IrqLock lock;
+    return _rxStallMs + (_rxThrottled ? HAL_GetTick() - _rxStallStart : 0);
+}
+
+/*----------------------------------------
+ * フロー制御（CTS）
+ *----------------------------------------*/
+void STM32BufferedSerial::setCtsPin(GPIO_TypeDef* port, uint16_t pin)
+{
+    _ctsPort = port;
+    _ctsPin = pin;
+}
+
+void STM32BufferedSerial::handleCtsChange()
+{
+    if (_ctsPort && HAL_GPIO_ReadPin(_ctsPort, _ctsPin) == GPIO_PIN_SET) return;
+    if (_txCtsStalled) {
+        _txStallMs = _txStallMs + (HAL_GetTick() - _txStallStart);
+        _txCtsStalled = false;
+    }
+    _startTxInterrupt();
+}
+
+/*----------------------------------------
+ * RS-485 半二重
+ *----------------------------------------*/
+bool STM32BufferedSerial::enableRs485(const Rs485Config& cfg)
+{
+#if !defined(USART_CR3_DEM)
+    if (!cfg.dePort) return false;   // ハードウェア DE の無い USART では GPIO が必須
+#endif
+    _rs485Cfg = cfg;
+    if (_rs485Cfg.assertTime > 31) _rs485Cfg.assertTime = 31;
+    if (_rs485Cfg.deassertTime > 31) _rs485Cfg.deassertTime = 31;
+
+#if defined(USART_CR3_DEM)
+    // ハードウェア DE: タイミングは USART が生成する
+    if (!_rs485Cfg.dePort)
+        HAL_RS485Ex_Init(_huart, UART_DE_POLARITY_HIGH,
+                         _rs485Cfg.assertTime, _rs485Cfg.deassertTime);
+#endif
+    if (_rs485Cfg.dePort) {
+        HAL_GPIO_WritePin(_rs485Cfg.dePort, _rs485Cfg.dePin, GPIO_PIN_RESET);
+        // GPIO のタイミング生成に DWT サイクルカウンタを使用
+        CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+    }
+    _deAsserted = false;
+    _rs485 = true;
+    return true;
+}
+
+void STM32BufferedSerial::_acquireBus()
+{
+    if (_deAsserted) return;
+    _deAsserted = true;
+    // 自分の送信のエコーを受信しないようレシーバを止める
+    if (_rs485Cfg.echoSuppress)
+        _huart->Instance->CR1 = _huart->Instance->CR1 & ~USART_CR1_RE;
+    // アサート時間の待ちは _startTxInterrupt() が割り込み許可状態で行う
+    if (_rs485Cfg.dePort)
+        HAL_GPIO_WritePin(_rs485Cfg.dePort, _rs485Cfg.dePin, GPIO_PIN_SET);
+}
+
+void STM32BufferedSerial::_releaseBus()
+{
+    if (!_deAsserted) return;
+    if (_rs485Cfg.dePort) {
+        _waitSampleTimes(_rs485Cfg.deassertTime);
+        HAL_GPIO_WritePin(_rs485Cfg.dePort, _rs485Cfg.dePin, GPIO_PIN_RESET);
+    }
+    if (_rs485Cfg.echoSuppress)
+        _huart->Instance->CR1 = _huart->Instance->CR1 | USART_CR1_RE;
+    _deAsserted = false;
+}
+
+void STM32BufferedSerial::_waitSampleTimes(uint8_t sampleTimes) const
+{
+    if (sampleTimes == 0) return;
+    uint32_t oversampling = (_huart->Init.OverSampling == UART_OVERSAMPLING_8) ? 8 : 16;
+    uint32_t cycles = static_cast<uint32_t>(
+        static_cast<uint64_t>(SystemCoreClock) * sampleTimes / (_huart->Init.BaudRate * oversampling));
+    uint32_t start = DWT->CYCCNT;
+    while (DWT->CYCCNT - start < cycles) {}
+}
+
+/*----------------------------------------
+ * ソフトウェアフロー制御（XON/XOFF）
+ *----------------------------------------*/
+void STM32BufferedSerial::setSoftwareFlowControl(bool enable)
+{
+    {
+        IrqLock lock;
+        _xonxoff = enable;
+        if (!enable) {
+            _txCtrl = 0;
+            _txPaused = false;
+        }
+    }
+    _startTxInterrupt();
+}
+
+uint32_t STM32BufferedSerial::getTxStallMs() const
+{
+    IrqLock lock;
+    return _txStallMs + (_txCtsStalled ? HAL_GetTick() - _txStallStart : 0);
 }
 
 
@@ -154,15 +1048,345 @@ bool STM32BufferedSerial::available() const {
 }
 
 int STM32BufferedSerial::readable_len() const {
-	if(_rxHead < _rxTail)
-		return static_cast<int>(_rxSize-(_rxTail-_rxHead));
-	else return static_cast<int>(_rxHead - _rxTail);
+	return static_cast<int>((_rxHead - _rxTail) & _rxMask);
 }
 
 void STM32BufferedSerial::flushRx() {
-    _rxHead = _rxTail = 0;
+    {
+        IrqLock lock;
+        // _rxHead は ISR が更新するので読み出し位置を揃えるだけにする
+        _rxTail = _rxHead;
+        _rxFrameTail = _rxFrameHead;
+    }
+    _checkRxRelease();
 }
 
 void STM32BufferedSerial::flushTx() {
-    _txHead = _txTail = 0;
+    bool release = false;
+    {
+        IrqLock lock;
+        if (_txBusy && _txChunk != 0) {
+            // 送信中のチャンクを中断（XON/XOFF の送信は中断しない）
+            HAL_UART_AbortTransmit(_huart);
+            _txChunk = 0;
+            // RS-485 ではバスを解放するまで送信権を持ったままにする
+            release = _rs485;
+            _txBusy = release;
+        }
+        for (int i = 0; i < STM32BS_TX_LANES; i++) {
+            TxLane& q = _tx[i];
+            q.tail = q.head;
+            q.sent = q.queued;
+            q.frameStart = q.sent;
+            q.markTail = q.markHead;   // 破棄したフレームの通知は行わない
+            q.deficit = 0;
+        }
+        _txExt = false;
+        _txExtOff = 0;
+        if (_txCtsStalled) {
+            _txStallMs = _txStallMs + (HAL_GetTick() - _txStallStart);
+            _txCtsStalled = false;
+        }
+    }
+    if (release) {
+        // シフトレジスタ上の 1 バイトを送り切ってからバスを解放（割り込みは許可したまま待つ）
+        while (!__HAL_UART_GET_FLAG(_huart, UART_FLAG_TC)) {}
+        _releaseBus();
+        _txBusy = false;
+    }
+    _startTxInterrupt();  // 保留中の XON/XOFF、待っている間に書かれたデータがあれば送る
+}
+
+/*----------------------------------------
+ * 送信完了待ち
+ *----------------------------------------*/
+bool STM32BufferedSerial::isTxIdle() const {
+    for (int i = 0; i < STM32BS_TX_LANES; i++) {
+        if (_txPending(_tx[i])) return false;
+    }
+    return !_txBusy && !_txCtrl && !_deAsserted
+        && __HAL_UART_GET_FLAG(_huart, UART_FLAG_TC);
+}
+
+bool STM32BufferedSerial::drain(uint32_t timeoutMs, bool sleep) {
+    uint32_t start = HAL_GetTick();
+    while (!isTxIdle()) {
+        if (timeoutMs != HAL_MAX_DELAY && HAL_GetTick() - start >= timeoutMs)
+            return false;
+        // 最後の TC はフラグのみで割り込みにならない場合があるので、送信中だけスリープする
+        if (sleep && _txBusy)
+            __WFI();
+    }
+    return true;
+}
+
+/*----------------------------------------
+ * 通信設定の変更
+ *----------------------------------------*/
+bool STM32BufferedSerial::setBaud(uint32_t baud, uint32_t timeoutMs) {
+    UART_InitTypeDef init = _huart->Init;
+    init.BaudRate = baud;
+
+    // 16 倍オーバーサンプリングで届かない速度は 8 倍に切り替える
+    uint32_t pclk = _uartClock();
+    init.OverSampling = (baud > pclk / 16) ? UART_OVERSAMPLING_8 : UART_OVERSAMPLING_16;
+    return reconfigure(init, timeoutMs);
+}
+
+uint32_t STM32BufferedSerial::_uartClock() const {
+    // USART1/6 は APB2、それ以外は APB1
+#if defined(USART6)
+    if (_huart->Instance == USART1 || _huart->Instance == USART6)
+        return HAL_RCC_GetPCLK2Freq();
+#else
+    if (_huart->Instance == USART1)
+        return HAL_RCC_GetPCLK2Freq();
+#endif
+    return HAL_RCC_GetPCLK1Freq();
+}
+
+bool STM32BufferedSerial::reconfigure(const UART_InitTypeDef& init, uint32_t timeoutMs) {
+    uint32_t start = HAL_GetTick();
+    HAL_StatusTypeDef st;
+    for (;;) {
+        // 送信途中のバイトを新しい設定で壊さないよう、先に送り切る
+        uint32_t elapsed = HAL_GetTick() - start;
+        if (timeoutMs != HAL_MAX_DELAY && elapsed >= timeoutMs) return false;
+        if (!drain((timeoutMs == HAL_MAX_DELAY) ? HAL_MAX_DELAY : timeoutMs - elapsed)) return false;
+
+        IrqLock lock;
+        if (!isTxIdle()) continue;   // 割り込みからの write() で送信が始まった
+        // 受信待ちの 1 バイトだけを中止（リング上の受信済みデータはそのまま残る）
+        HAL_UART_AbortReceive(_huart);
+        bool idle = (_huart->Instance->CR1 & USART_CR1_IDLEIE) != 0;
+#if defined(USART_CR2_RTOEN)
+        bool rto = (_huart->Instance->CR2 & USART_CR2_RTOEN) != 0;
+        uint32_t rtor = _huart->Instance->RTOR;
+#endif
+
+        _huart->Init = init;
+        _huart->gState = HAL_UART_STATE_READY;   // MspInit を再実行しない
+#if defined(USART_CR2_ABREN)
+        // autoBaud() の後に残る自動検出を止める（HAL_UART_Init() は ABREN を変えない。CR2 は UE = 0 で書く）
+        __HAL_UART_DISABLE(_huart);
+        _huart->Instance->CR2 = _huart->Instance->CR2 & ~USART_CR2_ABREN;
+#endif
+#if defined(USART_CR3_DEM)
+        if (_rs485 && !_rs485Cfg.dePort)
+            st = HAL_RS485Ex_Init(_huart, UART_DE_POLARITY_HIGH,
+                                  _rs485Cfg.assertTime, _rs485Cfg.deassertTime);
+        else
+#endif
+            st = HAL_UART_Init(_huart);
+
+        // HAL_UART_Init() で消える割り込み設定を戻す
+#if defined(USART_CR2_RTOEN)
+        if (rto) {
+            _huart->Instance->RTOR = rtor;
+            HAL_UART_EnableReceiverTimeout(_huart);
+            __HAL_UART_ENABLE_IT(_huart, UART_IT_RTO);
+        }
+#endif
+        if (idle) {
+            __HAL_UART_CLEAR_IDLEFLAG(_huart);
+            __HAL_UART_ENABLE_IT(_huart, UART_IT_IDLE);
+        }
+        break;
+    }
+    if (st != HAL_OK) return false;
+
+    _startRxInterrupt();
+    _startTxInterrupt();   // 設定変更中に書き込まれたデータがあれば送る
+    return true;
+}
+
+/*----------------------------------------
+ * ボーレート自動検出
+ *----------------------------------------*/
+namespace {
+// 検出できる最低速度。1 フレームの計測で割り込みを止める時間の上限（10 ビット）を決める
+const uint32_t kAutoBaudMinBaud = 300;
+
+const uint32_t kStandardBauds[] = {
+    1200, 2400, 4800, 9600, 14400, 19200, 38400, 57600, 115200,
+    230400, 460800, 921600, 1000000, 1500000, 2000000, 3000000
+};
+
+float baudError(uint32_t measured, uint32_t baud) {
+    return (static_cast<float>(measured) - static_cast<float>(baud)) * 100.0f / static_cast<float>(baud);
+}
+}
+
+STM32BufferedSerial::AutoBaudResult STM32BufferedSerial::autoBaud(GPIO_TypeDef* rxPort, uint16_t rxPin,
+                                                                 uint32_t timeoutMs) {
+    AutoBaudResult r{false, 0, 0, 0.0f};
+    HAL_UART_AbortReceive(_huart);
+
+#if defined(USART_CR2_ABREN)
+    (void)rxPort;
+    (void)rxPin;
+    // ハードウェア自動検出: スタートビット長を USART が測定し BRR を設定する
+    const uint32_t advInit = _huart->AdvancedInit.AdvFeatureInit;
+    const uint32_t abrEnable = _huart->AdvancedInit.AutoBaudRateEnable;
+    _huart->AdvancedInit.AdvFeatureInit = advInit | UART_ADVFEATURE_AUTOBAUDRATE_INIT;
+    _huart->AdvancedInit.AutoBaudRateEnable = UART_ADVFEATURE_AUTOBAUDRATE_ENABLE;
+    _huart->AdvancedInit.AutoBaudRateMode = UART_ADVFEATURE_AUTOBAUDRATE_ONSTARTBIT;
+    _huart->gState = HAL_UART_STATE_READY;
+    if (HAL_UART_Init(_huart) == HAL_OK) {
+        uint32_t start = HAL_GetTick();
+        while (!__HAL_UART_GET_FLAG(_huart, UART_FLAG_ABRF) && HAL_GetTick() - start < timeoutMs) {}
+        if (__HAL_UART_GET_FLAG(_huart, UART_FLAG_ABRF) && !__HAL_UART_GET_FLAG(_huart, UART_FLAG_ABRE)) {
+            // BRR から実際の速度を逆算（8 倍オーバーサンプリングでは下位 3 ビットが 1 ビット右シフトされている）
+            uint32_t brr = _huart->Instance->BRR;
+            uint32_t clock = _uartClock();
+            if (_huart->Init.OverSampling == UART_OVERSAMPLING_8) {
+                uint32_t div = (brr & 0xFFF0u) | ((brr & 0x7u) << 1);
+                r.measured = div ? 2 * clock / div : 0;
+            } else {
+                r.measured = brr ? clock / brr : 0;
+            }
+        }
+    }
+    // 以後の setBaud() / reconfigure() の HAL_UART_Init() が自動検出を再設定しないよう元に戻す
+    // （CR2 の ABREN は reconfigure() が落とす）
+    _huart->AdvancedInit.AdvFeatureInit = advInit;
+    _huart->AdvancedInit.AutoBaudRateEnable = abrEnable;
+    if (r.measured == 0) {
+        // 検出できなかった: 自動検出を止め、元の速度で受信を再開する
+        if (!reconfigure(_huart->Init)) _startRxInterrupt();
+        return r;
+    }
+
+    r.baud = r.measured;
+    for (uint32_t b : kStandardBauds) {
+        float e = baudError(r.measured, b);
+        if (e > -3.0f && e < 3.0f) {
+            r.baud = b;
+            break;
+        }
+    }
+    r.errorPercent = baudError(r.measured, r.baud);
+    // BRR はハードウェアが設定済み。以後の reconfigure() でも同じ速度になるよう実測値を記録する
+    _huart->Init.BaudRate = r.measured;
+    r.ok = true;
+    _startRxInterrupt();   // 最初のバイトは RDR に残っているので通常どおり受信される
+    return r;
+#else
+    uint32_t measured;
+    int firstByte;
+    if (!_measureBaud(rxPort, rxPin, timeoutMs, measured, firstByte)) {
+        _startRxInterrupt();
+        return r;
+    }
+    r.measured = measured;
+    r.baud = measured;
+    for (uint32_t b : kStandardBauds) {
+        float e = baudError(measured, b);
+        if (e > -3.0f && e < 3.0f) {
+            r.baud = b;
+            break;
+        }
+    }
+    r.errorPercent = baudError(measured, r.baud);
+
+    // 測定に使った最初のバイトは USART では正しく受信できていないので、復号した値を入れる
+    if (firstByte >= 0) push(static_cast<uint8_t>(firstByte));
+    r.ok = setBaud(r.baud);
+    if (!r.ok) _startRxInterrupt();
+    return r;
+#endif
+}
+
+namespace {
+// スタートビットの立ち下がり（時刻 t0）から 1 フレーム分のエッジを記録し、ビット時間と最初のバイトを求める。
+// 割り込み禁止の状態で呼ぶ。maxCycles を過ぎても終わらなければ（ブレーク、Low 固定）諦める
+bool captureFrame(GPIO_TypeDef* rxPort, uint16_t rxPin, uint32_t t0, uint32_t hz, uint64_t maxCycles,
+                  uint32_t& baud, int& firstByte) {
+    // 1 フレーム（スタート + 8 データ + ストップ）のエッジは最大 10 個
+    uint32_t edges[10];
+    int count = 0;
+    edges[count++] = 0;
+    bool level = false;
+
+    // 最短パルス幅の 10 倍（= 1 フレーム）経過し High になるまでエッジ時刻を記録
+    uint32_t minWidth = 0xFFFFFFFFu;
+    for (;;) {
+        uint32_t now = DWT->CYCCNT - t0;
+        bool pin = (rxPort->IDR & rxPin) != 0;
+        if (pin != level) {
+            level = pin;
+            uint32_t width = now - edges[count - 1];
+            if (width < minWidth) minWidth = width;
+            edges[count++] = now;
+            if (count == 10) break;
+        }
+        if (level && minWidth != 0xFFFFFFFFu && now >= 10 * static_cast<uint64_t>(minWidth)) break;
+        if (now >= maxCycles) return false;
+    }
+    if (count < 2) return false;
+
+    // 各区間を最短幅の整数倍とみなして平均ビット時間を求める
+    uint32_t total = 0, bits = 0;
+    for (int i = 1; i < count; i++) {
+        uint32_t width = edges[i] - edges[i - 1];
+        uint32_t k = (width + minWidth / 2) / minWidth;
+        if (k == 0) k = 1;
+        total += width;
+        bits += k;
+    }
+    uint32_t bitCycles = total / bits;
+    if (bitCycles == 0) return false;
+    baud = (hz + bitCycles / 2) / bitCycles;
+
+    // ビット中央のレベルから最初のバイトを復号（LSB ファースト）
+    int value = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        uint32_t center = bitCycles * (bit + 1) + bitCycles / 2;
+        int toggles = 0;
+        for (int i = 1; i < count; i++) {
+            if (edges[i] <= center) toggles++;
+        }
+        if (toggles & 1) value |= 1 << bit;   // スタートビット（Low）から奇数回反転 = High
+    }
+    firstByte = value;
+    return true;
+}
+}
+
+bool STM32BufferedSerial::_measureBaud(GPIO_TypeDef* rxPort, uint16_t rxPin, uint32_t timeoutMs,
+                                       uint32_t& baud, int& firstByte) {
+    CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+    const uint32_t hz = HAL_RCC_GetHCLKFreq();
+    const uint64_t timeoutCycles = static_cast<uint64_t>(hz / 1000) * timeoutMs;
+    // 割り込みを止めたままの計測は、最低速度の 1 フレーム分まで
+    uint64_t captureCycles = static_cast<uint64_t>(hz) * 10 / kAutoBaudMinBaud;
+    if (captureCycles > timeoutCycles) captureCycles = timeoutCycles;
+
+    // スタートビットは割り込みを許可したまま待つ。サンプル 1 回ごとに割り込みを止め、
+    // 立ち下がりを見つけたらそのまま 1 フレーム分だけ禁止を続けて測定する
+    uint64_t waited = 0;
+    uint32_t last = DWT->CYCCNT;
+    uint32_t fastest = 0xFFFFFFFFu;   // 割り込みが入らなかったときのサンプル間隔
+    bool idle = false;                // アイドル（High）を確認済み
+    for (;;) {
+        IrqLock lock;
+        bool pin = (rxPort->IDR & rxPin) != 0;
+        uint32_t now = DWT->CYCCNT;
+        uint32_t gap = now - last;
+        waited += gap;
+        last = now;
+        if (idle && !pin) {
+            // 直前のサンプルとの間に割り込みが入っていれば立ち下がりの時刻が分からない。
+            // そのフレームは測定に使わず、終わるのを待って次のフレームで測り直す
+            bool exact = gap <= 2 * fastest;
+            if (!captureFrame(rxPort, rxPin, now, hz, captureCycles, baud, firstByte)) return false;
+            if (exact) return true;
+            idle = false;
+            continue;
+        }
+        if (gap < fastest) fastest = gap;
+        if (pin) idle = true;
+        if (waited >= timeoutCycles) return false;
+    }
 }
@@ -0,0 +1,174 @@
+#include "../STM32BufferedSerialArduino.hpp"
+#include <cstring>
+
+STM32BufferedSerialArduino::STM32BufferedSerialArduino(STM32BufferedSerial& serial)
+    : _serial(serial), _timeout(1000)
+{
+}
+
+bool STM32BufferedSerialArduino::_waitUntil(uint32_t start) const
+{
+    if (HAL_GetTick() - start >= _timeout) return false;
+    __WFI();   // 受信割り込みまたは SysTick で起きる
+    return true;
+}
+
+/*----------------------------------------
+ * Stream の基本操作
+ *----------------------------------------*/
+int STM32BufferedSerialArduino::available()
+{
+    // Stream の available() は読めるバイト数（本体の available() は有無のみ）
+    return _serial.readable_len();
+}
+
+int STM32BufferedSerialArduino::read()
+{
+    return _serial.read();
+}
+
+int STM32BufferedSerialArduino::peek()
+{
+    return _serial.peek();
+}
+
+size_t STM32BufferedSerialArduino::write(uint8_t c)
+{
+    return (_serial.write(c) == 1) ? 1 : 0;
+}
+
+size_t STM32BufferedSerialArduino::write(const uint8_t* buf, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        size_t left = len - done;
+        int n = _serial.write(buf + done, static_cast<uint16_t>(left > 0xFFFF ? 0xFFFF : left));
+        if (n == 0) break;   // Arduino と同様、入りきらない分は返り値で通知
+        done += n;
+    }
+    return done;
+}
+
+size_t STM32BufferedSerialArduino::write(const char* s)
+{
+    return write(reinterpret_cast<const uint8_t*>(s), strlen(s));
+}
+
+int STM32BufferedSerialArduino::availableForWrite()
+{
+    return _serial.writable_len();
+}
+
+void STM32BufferedSerialArduino::flush()
+{
+    _serial.drain();
+}
+
+/*----------------------------------------
+ * タイムアウト付き読み出し
+ *----------------------------------------*/
+size_t STM32BufferedSerialArduino::readBytes(uint8_t* buffer, size_t length)
+{
+    uint32_t start = HAL_GetTick();
+    size_t got = 0;
+    while (got < length) {
+        size_t left = length - got;
+        got += _serial.read(buffer + got, static_cast<uint16_t>(left > 0xFFFF ? 0xFFFF : left));
+        if (got < length && !_waitUntil(start)) break;
+    }
+    return got;
+}
+
+size_t STM32BufferedSerialArduino::readBytesUntil(char terminator, uint8_t* buffer, size_t length)
+{
+    uint32_t start = HAL_GetTick();
+    uint8_t term = static_cast<uint8_t>(terminator);
+    size_t got = 0;
+    uint16_t scanned = 0;   // 終端文字が無いと確認済みのバイト数（読み出し位置から）
+
+    while (got < length) {
+        // 取り出さずに終端文字を探し、見つかった分をまとめてコピーする
+        STM32BufferedSerial::PeekView view = _serial.peekView();
+        size_t want = length - got;
+        uint16_t limit = (view.size() < want) ? view.size() : static_cast<uint16_t>(want > 0xFFFF ? 0xFFFF : want);
+        while (scanned < limit && view[scanned] != term) scanned++;
+
+        if (scanned < limit) {   // 終端文字を発見（終端は捨てる）
+            got += _serial.read(buffer + got, scanned);
+            _serial.rxConsume(1);
+            return got;
+        }
+        if (scanned >= want) {   // バッファが一杯
+            got += _serial.read(buffer + got, scanned);
+            return got;
+        }
+        if (!_waitUntil(start)) {   // タイムアウト: 届いた分だけ返す
+            got += _serial.read(buffer + got, scanned);
+            return got;
+        }
+    }
+    return got;
+}
+
+bool STM32BufferedSerialArduino::find(const char* target)
+{
+    return find(target, strlen(target));
+}
+
+bool STM32BufferedSerialArduino::find(const char* target, size_t length)
+{
+    if (length == 0) return true;
+    uint32_t start = HAL_GetTick();
+    for (;;) {
+        // 受信済みデータ上で照合し、一致すればそこまでを一度に消費する
+        STM32BufferedSerial::PeekView view = _serial.peekView();
+        uint16_t pos = 0;
+        while (pos + length <= view.size()) {
+            size_t i = 0;
+            while (i < length && view[pos + i] == static_cast<uint8_t>(target[i])) i++;
+            if (i == length) {
+                _serial.rxConsume(static_cast<uint16_t>(pos + length));
+                return true;
+            }
+            pos++;
+        }
+        // 途中まで一致している可能性のある末尾だけ残して捨てる
+        _serial.rxConsume(pos);
+        if (!_waitUntil(start)) return false;
+    }
+}
+
+long STM32BufferedSerialArduino::parseInt()
+{
+    uint32_t start = HAL_GetTick();
+    int c;
+    // 数字または '-' まで読み飛ばす
+    for (;;) {
+        c = _serial.peek();
+        if (c == '-' || (c >= '0' && c <= '9')) break;
+        if (c >= 0) _serial.read();
+        else if (!_waitUntil(start)) return 0;
+    }
+    bool negative = false;
+    long value = 0;
+    for (;;) {
+        c = _serial.peek();
+        if (c < 0) {
+            if (!_waitUntil(start)) break;
+            continue;
+        }
+        if (c == '-' && !negative && value == 0) negative = true;
+        else if (c >= '0' && c <= '9') value = value * 10 + (c - '0');
+        else break;
+        _serial.read();
+    }
+    return negative ? -value : value;
+}
+
+#if !defined(ARDUINO)
+size_t STM32BufferedSerialArduino::print(long v, int base)
+{
+    if (base == DEC) return static_cast<size_t>(_serial.print(v));
+    return static_cast<size_t>(_serial.print(static_cast<unsigned long>(v), static_cast<uint8_t>(base)));
+}
+#endif
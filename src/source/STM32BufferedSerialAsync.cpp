@@ -0,0 +1,199 @@
+#include "../STM32BufferedSerialAsync.hpp"
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include "IrqLock.hpp"
+
+/*----------------------------------------
+ * コルーチンフレーム用静的プール
+ *----------------------------------------*/
+namespace {
+alignas(std::max_align_t) uint8_t gFrames[STM32BS_ASYNC_FRAMES][STM32BS_ASYNC_FRAME_SIZE];
+bool gFrameUsed[STM32BS_ASYNC_FRAMES];
+}
+
+void* AsyncFramePool::allocate(std::size_t size) noexcept
+{
+    if (size > STM32BS_ASYNC_FRAME_SIZE) return nullptr;
+    IrqLock lock;
+    for (int i = 0; i < STM32BS_ASYNC_FRAMES; i++) {
+        if (!gFrameUsed[i]) {
+            gFrameUsed[i] = true;
+            return gFrames[i];
+        }
+    }
+    return nullptr;
+}
+
+void AsyncFramePool::release(void* p) noexcept
+{
+    IrqLock lock;
+    for (int i = 0; i < STM32BS_ASYNC_FRAMES; i++) {
+        if (p == gFrames[i]) {
+            gFrameUsed[i] = false;
+            return;
+        }
+    }
+}
+
+/*----------------------------------------
+ * スケジューラ（有界 MPSC キュー）
+ *----------------------------------------*/
+AsyncScheduler::AsyncScheduler()
+    : _tail(0), _head(0)
+{
+    for (uint32_t i = 0; i < STM32BS_ASYNC_READY_QUEUE; i++) {
+        _slots[i].seq.store(i, std::memory_order_relaxed);
+        _slots[i].address = nullptr;
+    }
+}
+
+bool AsyncScheduler::spawn(AsyncTask&& task)
+{
+    if (!task) return false;
+    std::coroutine_handle<> h = task.release();
+    if (!post(h)) {
+        h.destroy();
+        return false;
+    }
+    return true;
+}
+
+bool AsyncScheduler::post(std::coroutine_handle<> h)
+{
+    // スロットの seq が pos と一致すれば空き。CAS で位置を確保してから書き込む
+    // （Cortex-M では LDREX/STREX になり、優先度の異なる ISR から呼んでもロックしない）
+    uint32_t pos = _tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &_slots[pos & (STM32BS_ASYNC_READY_QUEUE - 1)];
+        int32_t diff = static_cast<int32_t>(slot->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // 満杯
+        } else {
+            pos = _tail.load(std::memory_order_relaxed);
+        }
+    }
+    slot->address = h.address();
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool AsyncScheduler::runOnce()
+{
+    Slot& slot = _slots[_head & (STM32BS_ASYNC_READY_QUEUE - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != _head + 1) return false;
+    void* address = slot.address;
+    slot.seq.store(_head + STM32BS_ASYNC_READY_QUEUE, std::memory_order_release);
+    _head++;
+    std::coroutine_handle<>::from_address(address).resume();
+    return true;
+}
+
+void AsyncScheduler::run()
+{
+    for (;;) {
+        if (!runOnce()) __WFI();
+    }
+}
+
+/*----------------------------------------
+ * AsyncSerial
+ *----------------------------------------*/
+AsyncSerial::AsyncSerial(STM32BufferedSerial& serial, AsyncScheduler& scheduler)
+    : _serial(serial), _scheduler(scheduler),
+      _rxOp(nullptr), _txOp(nullptr)
+{
+}
+
+void AsyncSerial::begin()
+{
+    _serial.setEventDeferral(false);
+    _serial.setEventCallback(&AsyncSerial::_onEvent, this, 0);
+}
+
+bool AsyncSerial::_rxProgress(RxOp& op)
+{
+    if (!op.until) {
+        op.got += _serial.read(op.buf + op.got, op.len - op.got);
+        return op.got == op.len;
+    }
+    while (op.got < op.len) {
+        int c = _serial.read();
+        if (c < 0) return false;
+        op.buf[op.got++] = static_cast<uint8_t>(c);
+        if (c == op.delimiter) return true;
+    }
+    return true;
+}
+
+bool AsyncSerial::_txProgress(TxOp& op)
+{
+    op.sent += _serial.write(op.data + op.sent, op.len - op.sent);
+    return op.sent == op.len;
+}
+
+bool AsyncSerial::_rxSuspend(RxOp& op, std::coroutine_handle<> h)
+{
+    IrqLock lock;
+    if (_rxProgress(op)) return false;   // 判定中に揃った: 中断せずに続行
+    op.handle = h;
+    _rxOp = &op;
+    _arm();
+    return true;
+}
+
+bool AsyncSerial::_txSuspend(TxOp& op, std::coroutine_handle<> h)
+{
+    IrqLock lock;
+    if (_txProgress(op)) return false;
+    op.handle = h;
+    _txOp = &op;
+    _arm();
+    return true;
+}
+
+void AsyncSerial::_arm()
+{
+    uint32_t mask = 0;
+    if (RxOp* rx = _rxOp) {
+        // 残りが揃うか区切り文字が届いた時点で ISR が起こす。
+        // THROTTLE では相手がハイウォーターマークで止まるので、それを超える件数は待たない
+        uint16_t need = rx->len - rx->got;
+        if (need > _serial.rxFillLimit()) need = static_cast<uint16_t>(_serial.rxFillLimit());
+        _serial.setEventCount(need);
+        mask |= STM32BufferedSerial::EVENT_RX_COUNT;
+        if (rx->until) {
+            _serial.setEventDelimiter(rx->delimiter);
+            mask |= STM32BufferedSerial::EVENT_RX_DELIMITER;
+        }
+    }
+    if (_txOp) mask |= STM32BufferedSerial::EVENT_TX_DONE;
+    _serial.setEventMask(mask);
+}
+
+void AsyncSerial::_onEvent(STM32BufferedSerial&, uint32_t events, void* context)
+{
+    auto self = static_cast<AsyncSerial*>(context);
+
+    // 中断中のコルーチンはそれぞれ高々 1 スロットしか使わず、キューはフレーム数以上ある
+    // （ヘッダの static_assert）ので、ここでの post() は失敗しない
+    if (RxOp* rx = self->_rxOp) {
+        if ((events & (STM32BufferedSerial::EVENT_RX_COUNT | STM32BufferedSerial::EVENT_RX_DELIMITER))
+            && self->_rxProgress(*rx)) {
+            self->_rxOp = nullptr;
+            (void)self->_scheduler.post(rx->handle);
+        }
+    }
+    if (TxOp* tx = self->_txOp) {
+        if ((events & STM32BufferedSerial::EVENT_TX_DONE) && self->_txProgress(*tx)) {
+            self->_txOp = nullptr;
+            (void)self->_scheduler.post(tx->handle);
+        }
+    }
+    self->_arm();
+}
+
+#endif
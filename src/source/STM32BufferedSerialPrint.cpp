@@ -0,0 +1,411 @@
+#include "../STM32BufferedSerial.hpp"
+#include "../Crc16.hpp"
+#include "IrqLock.hpp"
+#include <cstddef>
+
+namespace {
+
+// 2 桁ずつ変換するための "00" 〜 "99" の表（除算回数を半分にする）
+const char kDigitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+const uint32_t kPow10[10] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+
+/*----------------------------------------
+ * 数値 → 文字列（バッファ末尾から前に向かって書き、先頭を返す）
+ *----------------------------------------*/
+char* u32ToDec(char* end, uint32_t v) {
+    while (v >= 100) {
+        uint32_t r = v % 100;
+        v /= 100;
+        end -= 2;
+        end[0] = kDigitPairs[r * 2];
+        end[1] = kDigitPairs[r * 2 + 1];
+    }
+    if (v >= 10) {
+        end -= 2;
+        end[0] = kDigitPairs[v * 2];
+        end[1] = kDigitPairs[v * 2 + 1];
+    } else {
+        *--end = static_cast<char>('0' + v);
+    }
+    return end;
+}
+
+char* u64ToDec(char* end, uint64_t v) {
+    // 32 ビットに収まるまで 8 桁ずつ切り出す（64 ビット除算は大きな値のときだけ）
+    while (v > 0xFFFFFFFFu) {
+        uint64_t q = v / 100000000u;
+        uint32_t r = static_cast<uint32_t>(v - q * 100000000u);
+        char* p = u32ToDec(end, r);
+        while (end - p < 8) *--p = '0';
+        end = p;
+        v = q;
+    }
+    return u32ToDec(end, static_cast<uint32_t>(v));
+}
+
+char* u64ToPow2(char* end, uint64_t v, unsigned shift, bool upper) {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    const unsigned mask = (1u << shift) - 1;
+    do {
+        *--end = digits[v & mask];
+        v >>= shift;
+    } while (v);
+    return end;
+}
+
+char* doubleToFixed(char* end, double v, int prec) {
+    if (v != v) {                     // NaN
+        end -= 3;
+        end[0] = 'n'; end[1] = 'a'; end[2] = 'n';
+        return end;
+    }
+    if (v > 1.8e19) {                 // uint64_t に収まらない
+        end -= 3;
+        end[0] = 'o'; end[1] = 'v'; end[2] = 'f';
+        return end;
+    }
+    if (prec > 9) prec = 9;
+    uint64_t ip = static_cast<uint64_t>(v);
+    uint32_t scale = kPow10[prec];
+    uint32_t frac = static_cast<uint32_t>((v - static_cast<double>(ip)) * scale + 0.5);
+    if (frac >= scale) {              // 丸めで繰り上がり
+        frac -= scale;
+        ip++;
+    }
+    char* p = end;
+    if (prec) {
+        p = u32ToDec(p, frac);
+        while (end - p < prec) *--p = '0';
+        *--p = '.';
+    }
+    return u64ToDec(p, ip);
+}
+
+enum Length { LEN_HH, LEN_H, LEN_INT, LEN_L, LEN_LL, LEN_Z, LEN_T, LEN_J };
+
+int64_t fetchSigned(va_list& args, Length len) {
+    switch (len) {
+    case LEN_HH: return static_cast<signed char>(va_arg(args, int));
+    case LEN_H:  return static_cast<short>(va_arg(args, int));
+    case LEN_L:  return va_arg(args, long);
+    case LEN_LL: return va_arg(args, long long);
+    case LEN_Z:  return static_cast<int64_t>(va_arg(args, size_t));
+    case LEN_T:  return va_arg(args, ptrdiff_t);
+    case LEN_J:  return va_arg(args, intmax_t);
+    default:     return va_arg(args, int);
+    }
+}
+
+uint64_t fetchUnsigned(va_list& args, Length len) {
+    switch (len) {
+    case LEN_HH: return static_cast<unsigned char>(va_arg(args, unsigned int));
+    case LEN_H:  return static_cast<unsigned short>(va_arg(args, unsigned int));
+    case LEN_L:  return va_arg(args, unsigned long);
+    case LEN_LL: return va_arg(args, unsigned long long);
+    case LEN_Z:  return va_arg(args, size_t);
+    case LEN_T:  return static_cast<uint64_t>(va_arg(args, ptrdiff_t));
+    case LEN_J:  return va_arg(args, uintmax_t);
+    default:     return va_arg(args, unsigned int);
+    }
+}
+
+} // namespace
+
+/*----------------------------------------
+ * TX リングへの直接書き込み
+ *----------------------------------------*/
+bool STM32BufferedSerial::_stageBegin(TxStage& st) {
+    IrqLock lock;
+    if (_txStaging) return false;
+    // 書き込み位置を公開せずに空き領域へ直接書き、最後にまとめて公開する
+    TxLane& q = _tx[0];
+    _txStaging = true;
+    st = TxStage{q.buf, q.size, q.head, _txFree(q), 0};
+    return true;
+}
+
+int STM32BufferedSerial::_stageCommit(const TxStage& st) {
+    TxLane& q = _tx[0];
+    {
+        IrqLock lock;
+        if (st.count) {
+            q.queued += st.count;
+            q.head = st.pos;
+            _txMark(q, nullptr, nullptr);
+        }
+        _txStaging = false;
+    }
+    if (st.count && !_txBusy)
+        _startTxInterrupt();
+    return st.count;
+}
+
+/*----------------------------------------
+ * 書式化
+ *----------------------------------------*/
+void STM32BufferedSerial::_format(TxStage& st, const char* fmt, va_list& args) {
+    while (*fmt) {
+        char c = *fmt++;
+        if (c != '%') {
+            st.put(c);
+            continue;
+        }
+
+        // フラグ・幅・精度・長さ修飾子
+        bool left = false, zero = false;
+        char sign = 0;
+        for (;; fmt++) {
+            if (*fmt == '-') left = true;
+            else if (*fmt == '0') zero = true;
+            else if (*fmt == '+') sign = '+';
+            else if (*fmt == ' ') { if (!sign) sign = ' '; }
+            else if (*fmt != '#') break;
+        }
+        int width = 0;
+        if (*fmt == '*') {
+            width = va_arg(args, int);
+            if (width < 0) { left = true; width = -width; }
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') width = width * 10 + (*fmt++ - '0');
+        }
+        int prec = -1;
+        if (*fmt == '.') {
+            fmt++;
+            prec = 0;
+            if (*fmt == '*') {
+                prec = va_arg(args, int);
+                if (prec < 0) prec = -1;
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9') prec = prec * 10 + (*fmt++ - '0');
+            }
+        }
+        Length len = LEN_INT;
+        switch (*fmt) {
+        case 'h': fmt++; len = LEN_H; if (*fmt == 'h') { fmt++; len = LEN_HH; } break;
+        case 'l': fmt++; len = LEN_L; if (*fmt == 'l') { fmt++; len = LEN_LL; } break;
+        case 'z': fmt++; len = LEN_Z; break;
+        case 't': fmt++; len = LEN_T; break;
+        case 'j': fmt++; len = LEN_J; break;
+        default: break;
+        }
+
+        char conv = *fmt;
+        if (!conv) break;
+        fmt++;
+
+        char tmp[40];
+        char* end = tmp + sizeof(tmp);
+        char* p = end;
+        char prefix = 0;
+        bool integer = true;
+
+        switch (conv) {
+        case 'd':
+        case 'i': {
+            int64_t v = fetchSigned(args, len);
+            uint64_t u = (v < 0) ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+            prefix = (v < 0) ? '-' : sign;
+            p = u64ToDec(end, u);
+            if (prec == 0 && u == 0) p = end;
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o': {
+            uint64_t u = fetchUnsigned(args, len);
+            if (conv == 'u') p = u64ToDec(end, u);
+            else p = u64ToPow2(end, u, (conv == 'o') ? 3 : 4, conv == 'X');
+            if (prec == 0 && u == 0) p = end;
+            break;
+        }
+        case 'p':
+            p = u64ToPow2(end, reinterpret_cast<uintptr_t>(va_arg(args, void*)), 4, false);
+            *--p = 'x';
+            *--p = '0';
+            integer = false;
+            zero = false;
+            break;
+        case 'c':
+            *--p = static_cast<char>(va_arg(args, int));
+            integer = false;
+            zero = false;
+            break;
+        case 's': {
+            const char* s = va_arg(args, const char*);
+            if (!s) s = "(null)";
+            int n = 0;
+            while (s[n] && (prec < 0 || n < prec)) n++;
+            if (!left) st.pad(' ', width - n);
+            st.put(s, static_cast<uint16_t>(n));
+            if (left) st.pad(' ', width - n);
+            continue;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G': {
+            double v = va_arg(args, double);
+            prefix = (v < 0) ? '-' : sign;
+            p = doubleToFixed(end, (v < 0) ? -v : v, (prec < 0) ? 6 : prec);
+            integer = false;
+            break;
+        }
+        case '%':
+            st.put('%');
+            continue;
+        default:   // 未対応の変換はそのまま出力
+            st.put('%');
+            st.put(conv);
+            continue;
+        }
+
+        // 整数の精度は最小桁数（このとき '0' フラグは無視）
+        if (integer && prec >= 0) {
+            if (prec > static_cast<int>(sizeof(tmp)) - 1) prec = sizeof(tmp) - 1;
+            while (end - p < prec) *--p = '0';
+            zero = false;
+        }
+        int n = static_cast<int>(end - p);
+        int padn = width - n - (prefix ? 1 : 0);
+        if (!left && !zero) st.pad(' ', padn);
+        if (prefix) st.put(prefix);
+        if (!left && zero) st.pad('0', padn);
+        st.put(p, static_cast<uint16_t>(n));
+        if (left) st.pad(' ', padn);
+    }
+}
+
+int STM32BufferedSerial::vprintf(const char* fmt, va_list args) {
+    TxStage st;
+    if (!_stageBegin(st)) return 0;
+    va_list copy;
+    va_copy(copy, args);
+    _format(st, fmt, copy);
+    va_end(copy);
+    return _stageCommit(st);
+}
+
+int STM32BufferedSerial::printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n;
+}
+
+/*----------------------------------------
+ * print 系
+ *----------------------------------------*/
+int STM32BufferedSerial::print(const char* s) {
+    TxStage st;
+    if (!_stageBegin(st)) return 0;
+    while (*s) st.put(*s++);
+    return _stageCommit(st);
+}
+
+int STM32BufferedSerial::print(int v) {
+    return print(static_cast<long>(v));
+}
+
+int STM32BufferedSerial::print(long v) {
+    char tmp[12];
+    char* end = tmp + sizeof(tmp);
+    uint32_t u = (v < 0) ? 0u - static_cast<uint32_t>(v) : static_cast<uint32_t>(v);
+    char* p = u32ToDec(end, u);
+    if (v < 0) *--p = '-';
+
+    TxStage st;
+    if (!_stageBegin(st)) return 0;
+    st.put(p, static_cast<uint16_t>(end - p));
+    return _stageCommit(st);
+}
+
+int STM32BufferedSerial::print(unsigned int v, uint8_t base) {
+    return print(static_cast<unsigned long>(v), base);
+}
+
+int STM32BufferedSerial::print(unsigned long v, uint8_t base) {
+    char tmp[34];
+    char* end = tmp + sizeof(tmp);
+    char* p;
+    switch (base) {
+    case 2:  p = u64ToPow2(end, v, 1, true); break;
+    case 8:  p = u64ToPow2(end, v, 3, true); break;
+    case 16: p = u64ToPow2(end, v, 4, true); break;
+    default: p = u32ToDec(end, static_cast<uint32_t>(v)); break;
+    }
+
+    TxStage st;
+    if (!_stageBegin(st)) return 0;
+    st.put(p, static_cast<uint16_t>(end - p));
+    return _stageCommit(st);
+}
+
+int STM32BufferedSerial::print(double v, uint8_t digits) {
+    char tmp[32];
+    char* end = tmp + sizeof(tmp);
+    char* p = doubleToFixed(end, (v < 0) ? -v : v, digits);
+    if (v < 0) *--p = '-';
+
+    TxStage st;
+    if (!_stageBegin(st)) return 0;
+    st.put(p, static_cast<uint16_t>(end - p));
+    return _stageCommit(st);
+}
+
+int STM32BufferedSerial::printFixed(int32_t v, uint8_t fracDigits) {
+    if (fracDigits > 9) fracDigits = 9;
+    char tmp[24];
+    char* end = tmp + sizeof(tmp);
+    uint32_t u = (v < 0) ? 0u - static_cast<uint32_t>(v) : static_cast<uint32_t>(v);
+    char* p = end;
+    if (fracDigits) {
+        p = u32ToDec(p, u % kPow10[fracDigits]);
+        while (end - p < fracDigits) *--p = '0';
+        *--p = '.';
+    }
+    p = u32ToDec(p, u / kPow10[fracDigits]);
+    if (v < 0) *--p = '-';
+
+    TxStage st;
+    if (!_stageBegin(st)) return 0;
+    st.put(p, static_cast<uint16_t>(end - p));
+    return _stageCommit(st);
+}
+
+int STM32BufferedSerial::println(const char* s) {
+    TxStage st;
+    if (!_stageBegin(st)) return 0;
+    while (*s) st.put(*s++);
+    st.put('\r');
+    st.put('\n');
+    return _stageCommit(st);
+}
+
+/*----------------------------------------
+ * バイナリログ
+ *----------------------------------------*/
+void STM32BufferedSerial::_logSeal(TxStage& st) {
+    // 同期バイトの次（長さ）から今の位置までの CRC。リングの折り返しは 2 回に分けて計算する
+    uint16_t n = st.count - 1;
+    uint16_t start = (st.pos + st.size - n) % st.size;
+    uint16_t first = st.size - start;
+    if (first > n) first = n;
+    uint16_t crc = crc16Modbus(&st.buf[start], first);
+    if (n > first) crc = crc16Modbus(st.buf, n - first, crc);
+    st.put(static_cast<char>(crc & 0xFF));
+    st.put(static_cast<char>(crc >> 8));
+}
@@ -0,0 +1,67 @@
+#ifdef STM32BS_RETARGET_STDIO
+
+#include "../STM32BufferedSerialRetarget.hpp"
+#include <cerrno>
+
+namespace {
+STM32BufferedSerial* volatile gStdio = nullptr;
+Stm32bsRetargetMode gMode = STM32BS_RETARGET_BLOCK;
+
+bool inInterrupt() {
+    return __get_IPSR() != 0;
+}
+}
+
+void stm32bsRetargetStdio(STM32BufferedSerial* serial, Stm32bsRetargetMode mode) {
+    gMode = mode;
+    gStdio = serial;
+}
+
+/*----------------------------------------
+ * newlib システムコール（syscalls.c の weak 定義を置き換える）
+ *----------------------------------------*/
+extern "C" int _write(int file, char* ptr, int len) {
+    if (file != 1 && file != 2) {
+        errno = EBADF;
+        return -1;
+    }
+    STM32BufferedSerial* serial = gStdio;
+    if (!serial) return len;   // 出力先なし: 捨てる
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(ptr);
+    int sent = 0;
+    while (sent < len) {
+        uint16_t chunk = (len - sent > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(len - sent);
+        int n = serial->write(data + sent, chunk);
+        sent += n;
+        if (n > 0) continue;
+        // 割り込みハンドラ内、またはノンブロッキング設定では残りを捨てる
+        if (gMode == STM32BS_RETARGET_NONBLOCK || inInterrupt()) break;
+        __WFI();   // 送信完了割り込みで空きができるまで待つ
+    }
+    // 捨てた分も書けたことにする（stdio のエラー状態で以後の出力が止まらないように）
+    return len;
+}
+
+extern "C" int _read(int file, char* ptr, int len) {
+    if (file != 0) {
+        errno = EBADF;
+        return -1;
+    }
+    STM32BufferedSerial* serial = gStdio;
+    if (!serial || len <= 0) return 0;
+
+    uint16_t max = (len > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(len);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(ptr);
+    for (;;) {
+        int n = serial->read(dst, max);
+        if (n > 0) return n;
+        if (gMode == STM32BS_RETARGET_NONBLOCK || inInterrupt()) {
+            errno = EAGAIN;
+            return -1;
+        }
+        __WFI();   // 受信割り込みを待つ
+    }
+}
+
+#endif
@@ -0,0 +1,139 @@
+#if defined(__has_include)
+#if __has_include("FreeRTOS.h")
+
+#include "../STM32BufferedSerialRtos.hpp"
+
+STM32BufferedSerialRtos::STM32BufferedSerialRtos(STM32BufferedSerial& serial)
+    : _serial(serial),
+      _rxWaiter(nullptr), _txWaiter(nullptr),
+      _rxEvents(0), _txEvents(0)
+{
+}
+
+void STM32BufferedSerialRtos::begin()
+{
+    _serial.setEventDeferral(false);
+    _serial.setEventCallback(&STM32BufferedSerialRtos::_onEvent, this, 0);
+}
+
+/*----------------------------------------
+ * ISR からの通知
+ *----------------------------------------*/
+void STM32BufferedSerialRtos::_onEvent(STM32BufferedSerial&, uint32_t events, void* context)
+{
+    auto self = static_cast<STM32BufferedSerialRtos*>(context);
+    BaseType_t woken = pdFALSE;
+
+    if ((events & self->_rxEvents) && self->_rxWaiter)
+        vTaskNotifyGiveFromISR(self->_rxWaiter, &woken);
+    if ((events & self->_txEvents) && self->_txWaiter)
+        vTaskNotifyGiveFromISR(self->_txWaiter, &woken);
+
+    portYIELD_FROM_ISR(woken);
+}
+
+void STM32BufferedSerialRtos::_updateMask()
+{
+    taskENTER_CRITICAL();
+    _serial.setEventMask(_rxEvents | _txEvents);
+    taskEXIT_CRITICAL();
+}
+
+bool STM32BufferedSerialRtos::_wait(TimeOut_t& timeOut, TickType_t& remaining)
+{
+    if (xTaskCheckForTimeOut(&timeOut, &remaining) != pdFALSE) return false;
+    ulTaskNotifyTake(pdTRUE, remaining);
+    return true;
+}
+
+/*----------------------------------------
+ * ブロッキング受信
+ *----------------------------------------*/
+int STM32BufferedSerialRtos::read(uint8_t* dst, uint16_t len, TickType_t timeout)
+{
+    TimeOut_t timeOut;
+    vTaskSetTimeOutState(&timeOut);
+    TickType_t remaining = timeout;
+    uint16_t got = static_cast<uint16_t>(_serial.read(dst, len));
+
+    _rxWaiter = xTaskGetCurrentTaskHandle();
+    while (got < len) {
+        // 残りバイト数が揃った時点でだけ起床する（リングに溜まりきらない要求は分割。
+        // THROTTLE ではハイウォーターマークで相手が止まるのでそこまで）
+        uint16_t need = len - got;
+        if (need > _serial.rxFillLimit()) need = static_cast<uint16_t>(_serial.rxFillLimit());
+        _serial.setEventCount(need);
+        _rxEvents = STM32BufferedSerial::EVENT_RX_COUNT;
+        _updateMask();
+
+        // 設定中に届いたデータを取りこぼさないよう再確認してから待つ
+        if (_serial.readable_len() < need && !_wait(timeOut, remaining)) {
+            got += _serial.read(dst + got, len - got);
+            break;
+        }
+        got += _serial.read(dst + got, len - got);
+    }
+    _rxEvents = 0;
+    _updateMask();
+    _rxWaiter = nullptr;
+    return got;
+}
+
+int STM32BufferedSerialRtos::readUntil(uint8_t* dst, uint16_t max, uint8_t delimiter, TickType_t timeout)
+{
+    TimeOut_t timeOut;
+    vTaskSetTimeOutState(&timeOut);
+    TickType_t remaining = timeout;
+    uint16_t got = 0;
+
+    _rxWaiter = xTaskGetCurrentTaskHandle();
+    _serial.setEventDelimiter(delimiter);
+    _rxEvents = STM32BufferedSerial::EVENT_RX_DELIMITER | STM32BufferedSerial::EVENT_RX_COUNT;
+    while (got < max) {
+        int c = _serial.read();
+        if (c >= 0) {
+            dst[got++] = static_cast<uint8_t>(c);
+            if (c == delimiter) break;
+            continue;
+        }
+        // 区切り文字、またはバッファを満たす分が届くまで待つ
+        uint16_t need = max - got;
+        if (need > _serial.rxFillLimit()) need = static_cast<uint16_t>(_serial.rxFillLimit());
+        _serial.setEventCount(need);
+        _updateMask();
+        if (!_serial.available() && !_wait(timeOut, remaining)) break;
+    }
+    _rxEvents = 0;
+    _updateMask();
+    _rxWaiter = nullptr;
+    return got;
+}
+
+/*----------------------------------------
+ * ブロッキング送信
+ *----------------------------------------*/
+int STM32BufferedSerialRtos::write(const uint8_t* src, uint16_t len, TickType_t timeout)
+{
+    TimeOut_t timeOut;
+    vTaskSetTimeOutState(&timeOut);
+    TickType_t remaining = timeout;
+    uint16_t sent = static_cast<uint16_t>(_serial.write(src, len));
+    if (sent == len) return sent;
+
+    _txWaiter = xTaskGetCurrentTaskHandle();
+    _txEvents = STM32BufferedSerial::EVENT_TX_DONE;
+    _updateMask();
+    while (sent < len) {
+        int n = _serial.write(src + sent, len - sent);
+        sent += n;
+        // 空きができるまで（送信チャンク完了まで）待つ
+        if (n == 0 && !_wait(timeOut, remaining)) break;
+    }
+    _txEvents = 0;
+    _updateMask();
+    _txWaiter = nullptr;
+    return sent;
+}
+
+#endif
+#endif
@@ -0,0 +1,110 @@
+#include "../STM32BufferedSerialStream.hpp"
+
+STM32BufferedSerialStreambuf::STM32BufferedSerialStreambuf(STM32BufferedSerial& serial, bool blocking)
+    : _serial(serial), _blocking(blocking)
+{
+}
+
+STM32BufferedSerialStreambuf::~STM32BufferedSerialStreambuf()
+{
+    _releaseGet();
+}
+
+bool STM32BufferedSerialStreambuf::_wait() const
+{
+    if (!_blocking || __get_IPSR() != 0) return false;
+    __WFI();   // 送受信割り込みを待つ
+    return true;
+}
+
+/*----------------------------------------
+ * 出力（put 領域は持たず、1 文字ずつ TX リングへ確定する）
+ *----------------------------------------*/
+STM32BufferedSerialStreambuf::int_type STM32BufferedSerialStreambuf::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+
+    // 予約を返す前に確定する。予約を持ち越すと、その間ほかの lane 0 の書き込みと printf() が失敗する
+    for (;;) {
+        uint16_t len;
+        uint8_t* region = _serial.txReserve(len);
+        if (region) {
+            *region = static_cast<uint8_t>(traits_type::to_char_type(c));
+            _serial.txCommit(1);
+            return c;
+        }
+        if (!_wait()) return traits_type::eof();
+    }
+}
+
+std::streamsize STM32BufferedSerialStreambuf::xsputn(const char_type* s, std::streamsize n)
+{
+    // 2 区間の memcpy でまとめて書き込む
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(s);
+    std::streamsize done = 0;
+    while (done < n) {
+        std::streamsize left = n - done;
+        uint16_t chunk = (left > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(left);
+        int queued = _serial.write(data + done, chunk);
+        done += queued;
+        if (queued == 0 && !_wait()) break;
+    }
+    return done;
+}
+
+int STM32BufferedSerialStreambuf::sync()
+{
+    _releaseGet();
+    return 0;
+}
+
+/*----------------------------------------
+ * 入力（get 領域 = RX リング上の連続領域）
+ *----------------------------------------*/
+void STM32BufferedSerialStreambuf::_releaseGet()
+{
+    if (!eback()) return;
+    _serial.rxConsume(static_cast<uint16_t>(gptr() - eback()));
+    setg(nullptr, nullptr, nullptr);
+}
+
+STM32BufferedSerialStreambuf::int_type STM32BufferedSerialStreambuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    _releaseGet();
+
+    for (;;) {
+        uint16_t len;
+        const uint8_t* region = _serial.rxPeekContiguous(len);
+        if (len) {
+            // get 領域は読み出し専用として扱う（pbackfail は既定のまま書き込まない）
+            char* p = const_cast<char*>(reinterpret_cast<const char*>(region));
+            setg(p, p, p + len);
+            return traits_type::to_int_type(*p);
+        }
+        if (!_wait()) return traits_type::eof();
+    }
+}
+
+std::streamsize STM32BufferedSerialStreambuf::showmanyc()
+{
+    // リング上の未消費分から、get 領域で読み終えた分を除く
+    return _serial.readable_len() - static_cast<int>(gptr() - eback());
+}
+
+std::streamsize STM32BufferedSerialStreambuf::xsgetn(char_type* s, std::streamsize n)
+{
+    _releaseGet();
+    uint8_t* dst = reinterpret_cast<uint8_t*>(s);
+    std::streamsize done = 0;
+    while (done < n) {
+        std::streamsize left = n - done;
+        uint16_t chunk = (left > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(left);
+        int got = _serial.read(dst + done, chunk);
+        done += got;
+        if (got == 0 && !_wait()) break;
+    }
+    return done;
+}
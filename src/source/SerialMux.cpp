@@ -0,0 +1,294 @@
+#include "../SerialMux.hpp"
+#include "../Crc16.hpp"
+#include <cstring>
+
+namespace {
+constexpr uint8_t TYPE_DATA = 1;
+constexpr uint8_t TYPE_CREDIT = 2;
+
+constexpr uint16_t MASK = SerialMux::RING_SIZE - 1;
+
+// リングから最大 len バイトをコピー（折り返し対応）
+inline void ringCopyOut(uint8_t* dst, const uint8_t* ring, uint16_t tail, uint16_t len)
+{
+    uint16_t idx = tail & MASK;
+    uint16_t first = SerialMux::RING_SIZE - idx;
+    if (first > len) first = len;
+    memcpy(dst, &ring[idx], first);
+    memcpy(dst + first, ring, len - first);
+}
+
+inline void ringCopyIn(uint8_t* ring, uint16_t head, const uint8_t* src, uint16_t len)
+{
+    uint16_t idx = head & MASK;
+    uint16_t first = SerialMux::RING_SIZE - idx;
+    if (first > len) first = len;
+    memcpy(&ring[idx], src, first);
+    memcpy(ring, src + first, len - first);
+}
+}
+
+SerialMux::SerialMux(STM32BufferedSerial& serial)
+    : _serial(serial), _ch(), _drrNext(0), _drrGranted(false), _dataQueued(0), _dataSent(0),
+      _rxFrame(), _rxDecoder(_rxFrame, MAX_RAW),
+      _txFrame(), _stats()
+{
+    begin();
+}
+
+void SerialMux::begin()
+{
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+        Channel& ch = _ch[i];
+        ch.rxHead = ch.rxTail = 0;
+        ch.txHead = ch.txTail = 0;
+        ch.rxExpected = 0;
+        ch.txSent = 0;
+        ch.txLimit = RING_SIZE;
+        ch.advertised = RING_SIZE;
+        ch.advertisedAt = HAL_GetTick();
+        ch.quantum = CHUNK;
+        ch.deficit = 0;
+    }
+    _drrNext = 0;
+    _drrGranted = false;
+    _rxDecoder.reset();
+    _stats = Stats();
+}
+
+/*----------------------------------------
+ * チャネル API
+ *----------------------------------------*/
+int SerialMux::write(uint8_t channel, const uint8_t* data, uint16_t len)
+{
+    if (channel >= CHANNELS) return 0;
+    Channel& ch = _ch[channel];
+    uint16_t space = RING_SIZE - static_cast<uint16_t>(ch.txHead - ch.txTail);
+    uint16_t n = len < space ? len : space;
+    ringCopyIn(ch.tx, ch.txHead, data, n);
+    ch.txHead += n;
+    return n;
+}
+
+int SerialMux::read(uint8_t channel, uint8_t* dst, uint16_t len)
+{
+    if (channel >= CHANNELS) return 0;
+    Channel& ch = _ch[channel];
+    uint16_t used = static_cast<uint16_t>(ch.rxHead - ch.rxTail);
+    uint16_t n = len < used ? len : used;
+    ringCopyOut(dst, ch.rx, ch.rxTail, n);
+    ch.rxTail += n;
+    return n;
+}
+
+int SerialMux::available(uint8_t channel) const
+{
+    if (channel >= CHANNELS) return 0;
+    return static_cast<uint16_t>(_ch[channel].rxHead - _ch[channel].rxTail);
+}
+
+int SerialMux::writable(uint8_t channel) const
+{
+    if (channel >= CHANNELS) return 0;
+    return RING_SIZE - static_cast<uint16_t>(_ch[channel].txHead - _ch[channel].txTail);
+}
+
+uint16_t SerialMux::credit(uint8_t channel) const
+{
+    if (channel >= CHANNELS) return 0;
+    // 相手の再起動直後などで古い値が残っていてもリング長を超えない
+    int16_t c = static_cast<int16_t>(_ch[channel].txLimit - _ch[channel].txSent);
+    if (c < 0) return 0;
+    return c > RING_SIZE ? RING_SIZE : static_cast<uint16_t>(c);
+}
+
+void SerialMux::setWeight(uint8_t channel, uint16_t quantum)
+{
+    if (channel >= CHANNELS) return;
+    _ch[channel].quantum = quantum ? quantum : 1;
+}
+
+/*----------------------------------------
+ * 周期処理
+ *----------------------------------------*/
+void SerialMux::poll()
+{
+    // 受信リングをその場でアンスタッフ
+    uint16_t avail;
+    const uint8_t* p;
+    while ((p = _serial.rxPeekContiguous(avail)) != nullptr && avail) {
+        for (uint16_t i = 0; i < avail; i++) {
+            HdlcDecoder::Result r = _rxDecoder.feed(p[i]);
+            if (r == HdlcDecoder::FRAME)
+                _handleFrame(_rxDecoder.frame(), _rxDecoder.length());
+            else if (r == HdlcDecoder::ERROR)
+                _stats.crcErrors++;
+        }
+        _serial.rxConsume(avail);
+    }
+
+    // クレジットを先に出す（相手の送信停止を最短で解く）
+    _sendCredits(HAL_GetTick());
+    _schedule();
+}
+
+void SerialMux::_sendCredits(uint32_t now)
+{
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+        Channel& ch = _ch[i];
+        // 受信済みで未読の分を除いた位置 + リング長 = 相手が送ってよい位置
+        uint16_t used = static_cast<uint16_t>(ch.rxHead - ch.rxTail);
+        uint16_t limit = static_cast<uint16_t>(ch.rxExpected - used + RING_SIZE);
+        uint16_t grown = static_cast<uint16_t>(limit - ch.advertised);
+
+        // 少量ずつの通知は避け（silly window）、取りこぼし対策に定期的に再通知
+        if (grown < RING_SIZE / 4 && now - ch.advertisedAt < STM32BS_MUX_CREDIT_REFRESH_MS)
+            continue;
+        if (!_sendFrame(STM32BS_TX_LANES - 1, TYPE_CREDIT, i, limit, nullptr, 0, nullptr, 0))
+            return;
+        ch.advertised = limit;
+        ch.advertisedAt = now;
+        _stats.creditsSent++;
+    }
+}
+
+uint16_t SerialMux::_sendable(uint8_t channel) const
+{
+    uint16_t queued = static_cast<uint16_t>(_ch[channel].txHead - _ch[channel].txTail);
+    uint16_t c = credit(channel);
+    return queued < c ? queued : c;
+}
+
+void SerialMux::_schedule()
+{
+    // Deficit Round Robin: 各チャネルは 1 巡につき quantum バイトまで
+    // シリアル側に渡す DATA フレームは送信中と次の 1 つまで（後から来た対話チャネルが
+    // 大量のバルクデータの後ろに並ばないように。CREDIT は別レーンなので対象外）
+    uint8_t idle = 0;
+    while (idle < CHANNELS) {
+        Channel& ch = _ch[_drrNext];
+        uint16_t avail = _sendable(_drrNext);
+        if (avail) {
+            idle = 0;
+            if (!_drrGranted) {
+                ch.deficit += ch.quantum;
+                _drrGranted = true;
+            }
+            while (avail && ch.deficit) {
+                uint16_t n = avail < CHUNK ? avail : CHUNK;
+                if (n > ch.deficit) n = static_cast<uint16_t>(ch.deficit);
+
+                if (static_cast<uint8_t>(_dataQueued - _dataSent) >= TX_DEPTH)
+                    return;
+
+                uint16_t idx = ch.txTail & MASK;
+                uint16_t first = RING_SIZE - idx;
+                if (first > n) first = n;
+                // 回線側が満杯なら同じチャネルの番のまま次回の poll() で続きから
+                if (!_sendFrame(0, TYPE_DATA, _drrNext, ch.txSent,
+                                &ch.tx[idx], first, ch.tx, n - first, &SerialMux::_onDataSent))
+                    return;
+                _dataQueued++;
+                ch.txTail += n;
+                ch.txSent += n;
+                ch.deficit -= n;
+                avail -= n;
+                _stats.chunksSent++;
+            }
+        } else {
+            idle++;
+        }
+        // 送るものが無くなったチャネルは余りを持ち越さない
+        if (avail == 0)
+            ch.deficit = 0;
+        _drrNext = (_drrNext + 1) % CHANNELS;
+        _drrGranted = false;
+    }
+}
+
+/*----------------------------------------
+ * 受信フレーム処理
+ *----------------------------------------*/
+void SerialMux::_handleFrame(const uint8_t* frame, uint16_t len)
+{
+    if (len < HEADER + 2) {
+        _stats.crcErrors++;
+        return;
+    }
+    uint16_t crc = crc16Modbus(frame, len - 2);
+    if ((frame[len - 2] | (frame[len - 1] << 8)) != crc) {
+        _stats.crcErrors++;
+        return;
+    }
+
+    uint8_t type = frame[0] >> 4;
+    uint8_t channel = frame[0] & 0x0F;
+    uint16_t offset = static_cast<uint16_t>(frame[1] | (frame[2] << 8));
+    uint16_t payloadLen = len - 2 - HEADER;
+    if (channel >= CHANNELS) {
+        _stats.crcErrors++;
+        return;
+    }
+
+    if (type == TYPE_DATA && payloadLen > 0 && payloadLen <= CHUNK) {
+        _stats.chunksReceived++;
+        _handleData(_ch[channel], offset, &frame[HEADER], payloadLen);
+    } else if (type == TYPE_CREDIT && payloadLen == 0) {
+        _ch[channel].txLimit = offset;
+    } else {
+        _stats.crcErrors++;
+    }
+}
+
+void SerialMux::_handleData(Channel& ch, uint16_t offset, const uint8_t* payload, uint16_t len)
+{
+    // 位置が飛んでいれば間のチャンクは失われている。その分は読み終えたものとして
+    // クレジットに戻すので、取りこぼしで窓が縮むことはない
+    int16_t gap = static_cast<int16_t>(offset - ch.rxExpected);
+    if (gap > 0)
+        _stats.lostBytes += gap;
+    ch.rxExpected = offset;
+
+    uint16_t space = RING_SIZE - static_cast<uint16_t>(ch.rxHead - ch.rxTail);
+    uint16_t n = len < space ? len : space;
+    ringCopyIn(ch.rx, ch.rxHead, payload, n);
+    ch.rxHead += n;
+    ch.rxExpected += len;
+    _stats.overflows += len - n;
+}
+
+/*----------------------------------------
+ * 送信フレーム生成
+ *----------------------------------------*/
+bool SerialMux::_sendFrame(uint8_t lane, uint8_t type, uint8_t channel, uint16_t offset,
+                           const uint8_t* a, uint16_t aLen, const uint8_t* b, uint16_t bLen,
+                           STM32BufferedSerial::TxDoneCallback done)
+{
+    uint8_t header[HEADER] = {
+        static_cast<uint8_t>((type << 4) | channel),
+        static_cast<uint8_t>(offset & 0xFF),
+        static_cast<uint8_t>(offset >> 8),
+    };
+    uint16_t crc = crc16Modbus(header, HEADER);
+    if (aLen) crc = crc16Modbus(a, aLen, crc);
+    if (bLen) crc = crc16Modbus(b, bLen, crc);
+    uint8_t tail[2] = {static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8)};
+
+    uint16_t n = 0;
+    _txFrame[n++] = HDLC_FLAG;
+    n = hdlcStuff(_txFrame, n, header, HEADER);
+    n = hdlcStuff(_txFrame, n, a, aLen);
+    n = hdlcStuff(_txFrame, n, b, bLen);
+    n = hdlcStuff(_txFrame, n, tail, 2);
+    _txFrame[n++] = HDLC_FLAG;
+
+    if (_serial.writable_len(lane) < n)
+        return false;
+    return _serial.writeLane(lane, _txFrame, n, done, this) == n;
+}
+
+void SerialMux::_onDataSent(STM32BufferedSerial&, void* context)
+{
+    auto self = static_cast<SerialMux*>(context);
+    self->_dataSent = self->_dataSent + 1;
+}
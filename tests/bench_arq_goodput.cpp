@@ -0,0 +1,105 @@
+/**
+ * @file bench_arq_goodput.cpp
+ * @brief ArqLink goodput versus bit error rate on a simulated 115200 baud full-duplex link.
+ *
+ * One side sends MTU-sized numbered messages as fast as the window allows while
+ * the other side only receives; bits on the wire flip with the given probability
+ * in both directions, so ACKs are lost too. Goodput is delivered payload bytes
+ * per second relative to the raw line rate (baud / 10). Every message has to
+ * arrive once, intact and in order, at every error rate.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "ArqLink.hpp"
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint16_t MESSAGES = 200;
+
+struct Result {
+    double goodput;       // 回線速度に対する割合
+    bool inOrder;
+    uint16_t delivered;
+    ArqLink::Stats tx;
+    ArqLink::Stats rx;
+};
+
+void fill(uint8_t* msg, uint16_t n)
+{
+    for (uint16_t i = 0; i < ArqLink::MTU; i++) msg[i] = static_cast<uint8_t>(n * 7 + i);
+    // フラグ・エスケープと同じ値も含める
+    msg[0] = 0x7E;
+    msg[1] = 0x7D;
+}
+
+Result measure(double ber)
+{
+    sim::reset();
+    Uart ua(USART1, BAUD), ub(USART2, BAUD);
+    sim::connect(USART1, USART2);
+    STM32BufferedSerial sa(&ua.h, 512), sb(&ub.h, 512);
+    sa.begin();
+    sb.begin();
+    ArqLink a(sa), b(sb);
+    a.begin();
+    b.begin();
+    sim::setBitErrorRate(ber, 7);
+
+    Result r{0.0, true, 0, {}, {}};
+    uint16_t queued = 0;
+    uint8_t msg[ArqLink::MTU], expect[ArqLink::MTU], got[ArqLink::MTU];
+    const uint64_t t0 = sim::now();
+    sim::runUntil([&] {
+        a.poll();
+        b.poll();
+        while (queued < MESSAGES) {
+            fill(msg, queued);
+            if (!a.send(msg, sizeof(msg))) break;
+            queued++;
+        }
+        int n;
+        while ((n = b.receive(got, sizeof(got))) >= 0) {
+            fill(expect, r.delivered);
+            if (n != ArqLink::MTU || std::memcmp(got, expect, sizeof(got)) != 0) r.inOrder = false;
+            r.delivered++;
+        }
+        return r.delivered == MESSAGES;
+    }, 60ull * 1000000000ull, sim::byteTime(BAUD) / 2);
+
+    double seconds = static_cast<double>(sim::now() - t0) / 1e9;
+    r.goodput = static_cast<double>(r.delivered) * ArqLink::MTU / seconds / (BAUD / 10.0);
+    r.tx = a.getStats();
+    r.rx = b.getStats();
+    sim::setBitErrorRate(0.0);
+    return r;
+}
+
+} // namespace
+
+TEST(goodput_versus_bit_error_rate)
+{
+    std::printf("  %-8s %9s %8s %8s %8s %8s\n", "BER", "goodput", "frames", "retx", "crcErr", "acks");
+    const double bers[] = {0.0, 1e-5, 1e-4, 3e-4, 1e-3};
+    double previous = 1.0;
+    for (double ber : bers) {
+        Result r = measure(ber);
+        std::printf("  %-8.0e %8.1f%% %8lu %8lu %8lu %8lu\n", ber, r.goodput * 100.0,
+                    static_cast<unsigned long>(r.tx.framesSent), static_cast<unsigned long>(r.tx.retransmissions),
+                    static_cast<unsigned long>(r.rx.crcErrors + r.tx.crcErrors),
+                    static_cast<unsigned long>(r.rx.acksSent));
+        CHECK_EQ(r.delivered, MESSAGES);
+        CHECK(r.inOrder);
+        // 誤りが増えても goodput は（測定の揺らぎを除いて）上がらない
+        CHECK(r.goodput <= previous * 1.05);
+        if (ber == 0.0) {
+            // 誤りがなければ、オーバーヘッドはヘッダ・CRC・スタッフィングだけ。
+            // 送り終わりで ACK 遅延の分だけ RTT が伸び、RTTVAR が小さいと 1 回ほど早まった再送が起きる
+            CHECK(r.tx.retransmissions <= 2u);
+            CHECK(r.goodput > 0.75);
+        }
+        previous = r.goodput;
+    }
+}
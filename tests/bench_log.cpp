@@ -0,0 +1,92 @@
+/**
+ * @file bench_log.cpp
+ * @brief STM32BS_LOG() binary records versus printf() text on the same formats and arguments.
+ *
+ * Reports host time per call (only the calls are timed, the ring is drained between
+ * batches) and wire bytes per record / line. Both columns include the same simulated
+ * IrqLock / TX kick per call, so the time difference is what formatting costs. The
+ * byte ratio is what the link saves; it does not depend on the host.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t BAUD = 1000000;
+constexpr uint16_t RING = 4096;
+constexpr uint32_t CALLS = 20000;
+constexpr int MAX_LINE = 96;
+
+struct Result {
+    double nsPerCall;
+    double bytesPerCall;
+};
+
+template <typename F>
+Result measure(F&& fn)
+{
+    sim::reset();
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+
+    uint64_t ns = 0, bytes = 0;
+    uint32_t i = 0;
+    while (i < CALLS) {
+        auto t0 = std::chrono::steady_clock::now();
+        while (i < CALLS && serial.writable_len() >= MAX_LINE) {
+            fn(serial, i);
+            i++;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+        // 計測外で送り切り、回線に出たバイト数を数える
+        sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * (RING + 16), sim::byteTime(BAUD) * 64);
+        bytes += sim::wire(USART2).size();
+        sim::clearWire(USART2);
+    }
+    return Result{static_cast<double>(ns) / CALLS, static_cast<double>(bytes) / CALLS};
+}
+
+struct Row {
+    double logNs, textNs, logBytes, textBytes;
+};
+
+Row report(const char* name, const Result& log, const Result& text)
+{
+    std::printf("  %-8s %9.1f ns %9.1f ns %7.1f B %7.1f B %6.1fx\n", name, log.nsPerCall, text.nsPerCall,
+                log.bytesPerCall, text.bytesPerCall, text.bytesPerCall / log.bytesPerCall);
+    return Row{log.nsPerCall, text.nsPerCall, log.bytesPerCall, text.bytesPerCall};
+}
+
+} // namespace
+
+// 同じ書式・引数で STM32BS_LOG() と printf() を比べる（整数は MCU と同じ 32 ビット）
+#define COMPARE(name, fmt, ...)                                                                    \
+    report(name,                                                                                   \
+           measure([](STM32BufferedSerial& s, uint32_t i) { STM32BS_LOG(s, fmt, __VA_ARGS__); }),   \
+           measure([](STM32BufferedSerial& s, uint32_t i) { s.printf(fmt "\r\n", __VA_ARGS__); }))
+
+TEST(log_versus_printf)
+{
+    std::printf("  %-8s %12s %12s %9s %9s %7s\n", "format", "LOG", "printf()", "record", "line", "bytes");
+    Row rows[] = {
+        COMPARE("adc", "adc ch0=%" PRIu32 " ch1=%" PRIu32 " ch2=%" PRIu32 " ch3=%" PRIu32 " mV", i & 0xFFFu,
+                (i * 7u) & 0xFFFu, (i * 13u) & 0xFFFu, (i * 29u) & 0xFFFu),
+        COMPARE("event", "motor: state changed from %d to %d after %" PRIu32 " ms", static_cast<int>(i % 9u),
+                static_cast<int>((i + 1) % 9u), i * 1000u),
+        COMPARE("float", "temperature %.2f C, setpoint %.2f C", i * 0.125 - 500.0, i * 0.75 + 0.25),
+        COMPARE("hex", "reg %08" PRIx32 " = %08" PRIx32, 0x40004400u + (i & 0xFFu) * 4u, i * 0x10001u),
+        COMPARE("string", "%s: ready", (i & 1) ? "motor" : "pump"),
+    };
+    // 回線のバイト数はホストに依存しない。固定文字列の多い行ほど差が大きく、
+    // 短い文字列引数だけの行はテキストと同程度になる
+    for (int r = 0; r < 4; r++) CHECK(rows[r].textBytes / rows[r].logBytes > 1.5);
+    CHECK(rows[4].logBytes <= rows[4].textBytes + 4);
+}
@@ -0,0 +1,136 @@
+/**
+ * @file bench_mux_fairness.cpp
+ * @brief SerialMux throughput, DRR fairness between saturated channels, and the
+ *        latency of a short write on a console channel behind bulk traffic.
+ *
+ * Two ports are cross-connected at 115200 baud. One side only writes, the other
+ * reads every channel as fast as it arrives, so credit never limits the sender.
+ * Throughput is delivered payload per second relative to the raw line rate
+ * (baud / 10); shares are measured over a fixed window once all channels are busy.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "SerialMux.hpp"
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+
+struct Link {
+    Uart ua{USART1, BAUD}, ub{USART2, BAUD};
+    STM32BufferedSerial sa{&ua.h, 512}, sb{&ub.h, 512};
+    SerialMux tx{sa}, rx{sb};
+    uint32_t received[SerialMux::CHANNELS] = {};
+
+    Link()
+    {
+        sim::connect(USART1, USART2);
+        sa.begin();
+        sb.begin();
+        tx.begin();
+        rx.begin();
+    }
+
+    // 送信側は指定したチャネルを満たし続け、受信側はすべて読み出す
+    void step(const bool* bulk)
+    {
+        static const uint8_t fill[SerialMux::RING_SIZE] = {0x7E, 0x11, 0x7D, 0x22};
+        for (uint8_t c = 0; c < SerialMux::CHANNELS; c++) {
+            if (bulk[c]) tx.write(c, fill, static_cast<uint16_t>(tx.writable(c)));
+        }
+        tx.poll();
+        rx.poll();
+        uint8_t buf[SerialMux::RING_SIZE];
+        for (uint8_t c = 0; c < SerialMux::CHANNELS; c++) received[c] += rx.read(c, buf, sizeof(buf));
+    }
+
+    void run(const bool* bulk, uint64_t ns)
+    {
+        sim::runUntil([&] { step(bulk); return false; }, ns, sim::byteTime(BAUD) / 2);
+    }
+};
+
+} // namespace
+
+TEST(single_channel_throughput)
+{
+    Link link;
+    const bool bulk[SerialMux::CHANNELS] = {true};
+    link.run(bulk, sim::byteTime(BAUD) * 200);   // 立ち上がりを除く
+    uint32_t before = link.received[0];
+    const uint64_t window = sim::byteTime(BAUD) * 5000;
+    link.run(bulk, window);
+    double rate = (link.received[0] - before) / (window / 1e9) / (BAUD / 10.0);
+    std::printf("  single channel: %.1f%% of line rate (chunk %u)\n", rate * 100.0, SerialMux::CHUNK);
+    // ヘッダ 3 + CRC 2 + フラグ 2 とスタッフィングの分だけ減る
+    CHECK(rate > 0.80);
+    CHECK_EQ(link.tx.getStats().crcErrors + link.rx.getStats().crcErrors, 0u);
+    CHECK_EQ(link.rx.getStats().lostBytes, 0u);
+}
+
+TEST(drr_shares_follow_weights)
+{
+    Link link;
+    // 重み 1 : 1 : 2（quantum 32 / 32 / 64）
+    link.tx.setWeight(0, 32);
+    link.tx.setWeight(1, 32);
+    link.tx.setWeight(2, 64);
+    const bool bulk[SerialMux::CHANNELS] = {true, true, true};
+    link.run(bulk, sim::byteTime(BAUD) * 200);
+    uint32_t before[3] = {link.received[0], link.received[1], link.received[2]};
+    link.run(bulk, sim::byteTime(BAUD) * 8000);
+
+    double got[3], total = 0;
+    for (int c = 0; c < 3; c++) {
+        got[c] = link.received[c] - before[c];
+        total += got[c];
+    }
+    const double weight[3] = {0.25, 0.25, 0.5};
+    // 重みで割った取り分の Jain 指数（1.0 = 重みどおり）
+    double sum = 0, sumSq = 0;
+    for (int c = 0; c < 3; c++) {
+        double x = got[c] / total / weight[c];
+        sum += x;
+        sumSq += x * x;
+        std::printf("  channel %d: weight %.2f share %.3f\n", c, weight[c], got[c] / total);
+        CHECK(got[c] / total > weight[c] * 0.9 && got[c] / total < weight[c] * 1.1);
+    }
+    double jain = sum * sum / (3 * sumSq);
+    std::printf("  weighted Jain index: %.4f\n", jain);
+    CHECK(jain > 0.99);
+}
+
+// バルク 2 チャネルの後ろでも、コンソールの短い書き込みが待つのはシリアル側に渡した 2 チャンクと
+// DRR でコンソールより先に番が来るバルクチャネルの 1 チャンクずつだけ（TX バッファの滞留量によらない）
+TEST(console_latency_behind_bulk)
+{
+    Link link;
+    link.tx.setWeight(3, 16);
+    const bool bulk[SerialMux::CHANNELS] = {true, true, false, false};
+    link.run(bulk, sim::byteTime(BAUD) * 200);
+
+    const uint64_t slot = sim::byteTime(BAUD);
+    uint64_t worst = 0, sum = 0;
+    const int SAMPLES = 50;
+    uint32_t rng = 99;
+    for (int i = 0; i < SAMPLES; i++) {
+        rng = rng * 1103515245u + 12345u;
+        link.run(bulk, slot * (20 + (rng >> 16) % 100));
+        uint32_t before = link.received[3];
+        uint64_t t0 = sim::now();
+        link.tx.write(3, reinterpret_cast<const uint8_t*>("status\r\n"), 8);
+        sim::runUntil([&] { link.step(bulk); return link.received[3] >= before + 8; }, slot * 1000, slot / 2);
+        uint64_t latency = sim::now() - t0;
+        sum += latency;
+        if (latency > worst) worst = latency;
+    }
+    // バルクのフレーム（フラグ 2 + ヘッダ 3 + CRC 2、データ中の 0x7E / 0x7D のスタッフィング 2）を
+    // 送信中・待機中・各バルクチャネル 1 つずつの計 4 つ + 全チャネルの CREDIT + 自分のフレーム + poll 周期の余裕
+    const double frame = 2 + 3 + SerialMux::CHUNK + 2 + 2;
+    const double credits = SerialMux::CHANNELS * (2 + 3 + 2 + 1);
+    double bound = 4 * frame + credits + (2 + 3 + 8 + 2) + 4;
+    std::printf("  console latency: mean %.1f ch, max %.1f ch, bound %.1f ch\n",
+                static_cast<double>(sum) / SAMPLES / slot, static_cast<double>(worst) / slot, bound);
+    CHECK(static_cast<double>(worst) / slot <= bound);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file bench_printf.cpp
+ * @brief printf() rendered into the TX ring versus snprintf() into a stack buffer + write().
+ *
+ * Both variants format the same arguments with the same format string. Only the calls
+ * are timed (host CPU time, with the ring kept from filling up between batches); the
+ * wire output of the two runs must be identical. Host timings say nothing absolute
+ * about a Cortex-M, and both columns include the same simulated IrqLock / TX kick per
+ * call, but the difference shows what the extra copy and the C library cost.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t BAUD = 1000000;
+constexpr uint16_t RING = 4096;
+constexpr uint32_t CALLS = 20000;
+constexpr int MAX_LINE = 96;
+
+struct Result {
+    double nsPerCall;
+    double bytesPerCall;
+    uint32_t hash;   // 回線に出たバイト列の FNV-1a
+};
+
+template <typename F>
+Result measure(F&& fn)
+{
+    sim::reset();
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+
+    uint64_t ns = 0, bytes = 0;
+    uint32_t hash = 2166136261u;
+    uint32_t i = 0;
+    while (i < CALLS) {
+        auto t0 = std::chrono::steady_clock::now();
+        while (i < CALLS && serial.writable_len() >= MAX_LINE) {
+            bytes += static_cast<uint32_t>(fn(serial, i));
+            i++;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+        // 計測外で送り切る
+        sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * (RING + 16), sim::byteTime(BAUD) * 64);
+        for (const sim::WireByte& w : sim::wire(USART2)) hash = (hash ^ w.b) * 16777619u;
+        sim::clearWire(USART2);
+    }
+    return Result{static_cast<double>(ns) / CALLS, static_cast<double>(bytes) / CALLS, hash};
+}
+
+void report(const char* name, const Result& direct, const Result& copied)
+{
+    std::printf("  %-10s %10.1f ns %10.1f ns %7.2fx %8.1f B\n", name, direct.nsPerCall, copied.nsPerCall,
+                copied.nsPerCall / direct.nsPerCall, direct.bytesPerCall);
+    CHECK_EQ(direct.hash, copied.hash);
+    CHECK(direct.bytesPerCall == copied.bytesPerCall);
+}
+
+} // namespace
+
+// 同じ書式・引数で printf() と snprintf() + write() を比べる
+#define COMPARE(name, ...)                                                                 \
+    report(name,                                                                           \
+           measure([](STM32BufferedSerial& s, uint32_t i) { return s.printf(__VA_ARGS__); }), \
+           measure([](STM32BufferedSerial& s, uint32_t i) {                                \
+               char buf[MAX_LINE];                                                         \
+               int n = std::snprintf(buf, sizeof(buf), __VA_ARGS__);                       \
+               return s.write(reinterpret_cast<const uint8_t*>(buf), static_cast<uint16_t>(n)); \
+           }))
+
+TEST(printf_versus_snprintf_and_write)
+{
+    std::printf("  %-10s %13s %13s %8s %10s\n", "format", "printf()", "snprintf+write", "ratio", "line");
+    COMPARE("int", "t=%lu adc=%u,%u,%d\r\n", static_cast<unsigned long>(i) * 1000u, i & 0xFFFu,
+            (i * 7u) & 0xFFFu, static_cast<int>(i % 200u) - 100);
+    COMPARE("hex", "%08lx: %04x %04x %02x\r\n", static_cast<unsigned long>(i) * 0x10001u, i & 0xFFFFu,
+            (i * 31u) & 0xFFFFu, i & 0xFFu);
+    // 2 進で正確に表せる値にして、丸め方の違い（%f は半分切り上げ）で出力が分かれないようにする
+    COMPARE("float", "v=%.3f i=%.2f\r\n", i * 0.125 - 500.0, i * 0.75 + 0.25);
+    COMPARE("string", "%s: state %d of %s\r\n", (i & 1) ? "motor" : "pump", static_cast<int>(i % 9u),
+            "ready");
+}
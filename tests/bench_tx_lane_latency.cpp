@@ -0,0 +1,85 @@
+/**
+ * @file bench_tx_lane_latency.cpp
+ * @brief Latency of a short ACK on TX lane 1 while lane 0 is kept full of bulk frames.
+ *
+ * The ACK is written at pseudo-random points in the bulk stream. Latency runs from
+ * writeLane() to the TX complete interrupt of the ACK's last byte, in character
+ * times. Lanes are switched only at frame boundaries, so the ACK should wait for
+ * the rest of the bulk frame on the wire and no more, whatever the lane-0 backlog.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint16_t RING = 256;
+constexpr uint16_t ACK_LEN = 4;
+
+struct Result {
+    double meanChars;
+    double maxChars;
+    uint32_t acks;
+};
+
+void onAckSent(STM32BufferedSerial&, void* context)
+{
+    *static_cast<uint64_t*>(context) = sim::now();
+}
+
+Result measure(uint16_t frameLen)
+{
+    sim::reset();
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+
+    const uint64_t slot = sim::byteTime(BAUD);
+    uint8_t bulk[RING] = {};
+    const uint8_t ack[ACK_LEN] = {0xA5, 0x01, 0x02, 0x5A};
+
+    // レーン 0 を常に満たしておく
+    auto refill = [&] {
+        while (serial.writable_len(0) >= frameLen) serial.writeLane(0, bulk, frameLen);
+    };
+
+    uint32_t rng = 12345;
+    uint64_t sum = 0, worst = 0;
+    const uint32_t ACKS = 200;
+    for (uint32_t i = 0; i < ACKS; i++) {
+        refill();
+        // フレーム境界からずれた位置で ACK を書く
+        rng = rng * 1103515245u + 12345u;
+        uint64_t wait = slot * ((rng >> 16) % (2u * frameLen)) + (rng & 0xFFFF) % slot;
+        sim::runUntil([&] { refill(); return false; }, wait, slot / 4);
+        refill();
+
+        uint64_t done = 0;
+        uint64_t t0 = sim::now();
+        serial.writeLane(1, ack, ACK_LEN, onAckSent, &done);
+        sim::runUntil([&] { refill(); return done != 0; }, slot * (RING + 2 * ACK_LEN), slot / 4);
+        uint64_t latency = done ? done - t0 : slot * (RING + 2 * ACK_LEN);
+        sum += latency;
+        if (latency > worst) worst = latency;
+    }
+    return Result{static_cast<double>(sum) / ACKS / slot, static_cast<double>(worst) / slot, ACKS};
+}
+
+} // namespace
+
+TEST(ack_waits_for_one_bulk_frame_at_most)
+{
+    std::printf("  %-10s %10s %10s %10s\n", "frame", "mean", "max", "bound");
+    // 通知なしの区切りは STM32BS_TX_MARKERS 個まで保持されるので、リングがその数以下のフレームで埋まる長さで測る
+    const uint16_t frames[] = {32, 64, 128, 240};
+    for (uint16_t f : frames) {
+        Result r = measure(f);
+        // 送信中フレームの残り + ACK 本体 + 割り込み応答の余裕
+        double bound = f + ACK_LEN + 1;
+        std::printf("  %-10u %8.1f ch %8.1f ch %8.1f ch\n", f, r.meanChars, r.maxChars, bound);
+        CHECK(r.maxChars <= bound);
+        CHECK(r.meanChars < bound);
+    }
+}
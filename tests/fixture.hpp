@@ -0,0 +1,37 @@
+/**
+ * @file fixture.hpp
+ * @brief Shared set-up for tests that drive STM32BufferedSerial through the simulated USART.
+ */
+
+#ifndef STM32BS_TEST_FIXTURE_HPP
+#define STM32BS_TEST_FIXTURE_HPP
+
+#include "sim.hpp"
+#include <string>
+
+/** @brief UART handle initialised like MX_USARTx_UART_Init() would. */
+struct Uart {
+    UART_HandleTypeDef h;
+
+    explicit Uart(USART_TypeDef* instance, uint32_t baud = 115200) : h() {
+        h.Instance = instance;
+        h.Init.BaudRate = baud;
+        h.Init.WordLength = UART_WORDLENGTH_8B;
+        h.Init.StopBits = UART_STOPBITS_1;
+        h.Init.Parity = UART_PARITY_NONE;
+        h.Init.Mode = UART_MODE_TX_RX;
+        h.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+        h.Init.OverSampling = UART_OVERSAMPLING_16;
+        HAL_UART_Init(&h);
+    }
+};
+
+/** @brief Bytes that left the TX pin of @p usart, as a string for easy comparison. */
+inline std::string wireString(USART_TypeDef* usart)
+{
+    std::string s;
+    for (const sim::WireByte& w : sim::wire(usart)) s.push_back(static_cast<char>(w.b));
+    return s;
+}
+
+#endif
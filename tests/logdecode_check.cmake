@@ -0,0 +1,17 @@
+# Decode the capture written by test_log with tools/stm32bs_logdecode.py and
+# compare it with the expected text (run from the directory holding both files).
+#   cmake -DPYTHON=<python3> -DDECODER=<stm32bs_logdecode.py> -DELF=<test_log> -P logdecode_check.cmake
+execute_process(
+    COMMAND ${PYTHON} ${DECODER} ${ELF} log_capture.bin
+    OUTPUT_VARIABLE decoded
+    ERROR_VARIABLE notes
+    RESULT_VARIABLE status)
+file(READ log_expected.txt expected)
+message("${notes}")
+if(NOT status EQUAL 0)
+    message(FATAL_ERROR "decoder failed (${status})")
+endif()
+if(NOT decoded STREQUAL expected)
+    message(FATAL_ERROR "decoded:\n${decoded}\nexpected:\n${expected}")
+endif()
+message("${decoded}")
@@ -0,0 +1,29 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types used by STM32BufferedSerialRtos.
+ *
+ * Tasks are POSIX threads. Ticks are milliseconds of simulated time (sim.hpp).
+ */
+
+#ifndef STM32BS_TEST_FREERTOS_H
+#define STM32BS_TEST_FREERTOS_H
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef struct TaskStub* TaskHandle_t;
+typedef struct { uint32_t start; } TimeOut_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+#define taskENTER_CRITICAL() vPortEnterCritical()
+#define taskEXIT_CRITICAL() vPortExitCritical()
+
+#endif
@@ -0,0 +1,700 @@
+#include "sim.hpp"
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+
+/*----------------------------------------
+ * 周辺レジスタと内部状態
+ *----------------------------------------*/
+namespace {
+
+constexpr uint64_t NEVER = UINT64_MAX;
+constexpr uint32_t RX_ERRORS = USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE;
+
+struct Port {
+    USART_TypeDef regs;
+    UART_HandleTypeDef* h;
+    uint32_t baud;                      // HAL_UART_Init() で設定された速度
+    std::deque<uint8_t> fifo;           // DR + シフトレジスタ（最大 2 バイト）
+    uint64_t txDoneAt;                  // fifo 先頭のストップビット終了時刻
+    USART_TypeDef* peer;
+    std::vector<sim::WireByte> wire;
+    std::function<void()> irqHook;
+    std::function<void()> beforeError;
+    std::function<int()> source;
+    uint32_t sourceBaud;
+    uint64_t sourceNextAt;
+    bool rxSinceIdle;
+    uint64_t idleAt;
+    bool idlePending;
+    uint64_t pendingSince;              // 割り込み要求が立った時刻
+};
+
+Port gPorts[6];
+GPIO_TypeDef gGpio[3];
+DWT_Type gDwt;
+CoreDebug_Type gCoreDebug;
+SCB_Type gScb;
+
+struct PinState {
+    bool high = true;
+    std::function<bool(uint64_t)> wave;
+};
+std::map<std::pair<GPIO_TypeDef*, uint16_t>, PinState> gPins;
+std::vector<sim::PinWrite> gPinWrites;
+std::map<IRQn_Type, std::function<void()>> gSoftIrq;
+std::map<IRQn_Type, bool> gSoftPending;
+
+std::recursive_mutex gLock;             // 割り込み禁止中およびシミュレータ操作中に保持
+std::atomic<uint64_t> gNow{0};    // タスクのスレッドからも読む
+uint32_t gRegCost = 20;
+uint64_t gMaskedSince = 0;
+uint64_t gMaxMasked = 0;
+uint64_t gMaxLatency = 0;
+bool gExclusive = false;
+bool gDispatching = false;
+double gBer = 0.0;
+std::mt19937 gRng(1);
+
+thread_local uint32_t tPrimask = 0;
+thread_local uint32_t tIpsr = 0;
+
+Port* portOf(const USART_TypeDef* usart)
+{
+    for (Port& p : gPorts) {
+        if (&p.regs == usart) return &p;
+    }
+    return nullptr;
+}
+
+uint64_t charTime(uint32_t baud)
+{
+    return baud ? 10ull * 1000000000ull / baud : NEVER;
+}
+
+uint32_t readDr(Port& p)
+{
+    p.regs.SR.raw &= ~(USART_SR_RXNE | USART_SR_IDLE | RX_ERRORS);
+    return p.regs.DR.raw;
+}
+
+bool irqPending(const Port& p)
+{
+    const UART_HandleTypeDef* h = p.h;
+    if (!h) return false;
+    if (p.idlePending && (p.regs.CR1 & USART_CR1_IDLEIE)) return true;
+    if (h->RxState == HAL_UART_STATE_BUSY_RX && (p.regs.SR.raw & (USART_SR_RXNE | RX_ERRORS))) return true;
+    if (h->gState == HAL_UART_STATE_BUSY_TX) {
+        if (h->TxXferCount > 0 && p.fifo.size() < 2) return true;
+        if (h->TxXferCount == 0 && p.fifo.empty()) return true;
+    }
+    return false;
+}
+
+void markPending()
+{
+    for (Port& p : gPorts) {
+        if (p.pendingSince == NEVER && irqPending(p)) p.pendingSince = gNow;
+    }
+}
+
+/*----------------------------------------
+ * ハードウェア（マスクに関係なく進む）
+ *----------------------------------------*/
+void rxArrive(Port& p, uint8_t b, uint32_t errors)
+{
+    if (!(p.regs.CR1 & USART_CR1_RE)) return;   // レシーバ停止中
+    if (p.regs.SR.raw & USART_SR_RXNE) {
+        p.regs.SR.raw |= USART_SR_ORE;          // DR は前のバイトのまま
+    } else {
+        p.regs.DR.raw = b;
+        p.regs.SR.raw |= USART_SR_RXNE | errors;
+    }
+    p.rxSinceIdle = true;
+    p.idleAt = gNow + charTime(p.baud);
+}
+
+void txLoad(Port& p, uint8_t b)
+{
+    if (p.fifo.empty()) p.txDoneAt = gNow + charTime(p.baud);
+    p.fifo.push_back(b);
+    p.regs.SR.raw &= ~USART_SR_TC;
+}
+
+uint64_t nextHwEvent()
+{
+    uint64_t t = NEVER;
+    for (Port& p : gPorts) {
+        if (!p.fifo.empty() && p.txDoneAt < t) t = p.txDoneAt;
+        if (p.idleAt < t) t = p.idleAt;
+        if (p.source && p.sourceNextAt < t) t = p.sourceNextAt;
+    }
+    return t;
+}
+
+void hwEvents()
+{
+    for (Port& p : gPorts) {
+        if (!p.fifo.empty() && p.txDoneAt <= gNow) {
+            uint8_t b = p.fifo.front();
+            p.fifo.pop_front();
+            p.wire.push_back(sim::WireByte{gNow, b, p.baud});
+            if (p.peer) {
+                uint8_t rx = b;
+                if (gBer > 0.0) {
+                    std::bernoulli_distribution flip(gBer);
+                    for (int bit = 0; bit < 8; bit++) {
+                        if (flip(gRng)) rx ^= static_cast<uint8_t>(1u << bit);
+                    }
+                }
+                rxArrive(*portOf(p.peer), rx, 0);
+            }
+            if (p.fifo.empty()) p.regs.SR.raw |= USART_SR_TC;
+            else p.txDoneAt = gNow + charTime(p.baud);
+        }
+        if (p.source && p.sourceNextAt <= gNow) {
+            int v = p.source();
+            if (v >= 0) rxArrive(p, static_cast<uint8_t>(v), 0);
+            p.sourceNextAt = gNow + charTime(p.sourceBaud);
+        }
+    }
+    // 同時刻に次のバイトが届いていればアイドルではないので、到着を全部処理してから判定
+    for (Port& p : gPorts) {
+        if (p.idleAt <= gNow) {
+            // 相手がすでに次のバイトを送り始めていれば（スタートビットが来ていれば）アイドルではない
+            if (p.peer && !portOf(p.peer)->fifo.empty()) {
+                p.idleAt = NEVER;
+                continue;
+            }
+            p.idleAt = NEVER;
+            if (p.rxSinceIdle) {
+                p.rxSinceIdle = false;
+                p.regs.SR.raw |= USART_SR_IDLE;
+                p.idlePending = true;
+            }
+        }
+    }
+    markPending();
+}
+
+/*----------------------------------------
+ * 割り込み（HAL_UART_IRQHandler の IT モード部分を再現）
+ *----------------------------------------*/
+void halIrq(Port& p)
+{
+    UART_HandleTypeDef* h = p.h;
+    p.idlePending = false;
+    if (h->RxState == HAL_UART_STATE_BUSY_RX) {
+        uint32_t sr = p.regs.SR.raw;
+        uint32_t err = sr & RX_ERRORS;
+        if (sr & USART_SR_RXNE) {
+            *h->pRxBuffPtr++ = static_cast<uint8_t>(readDr(p));
+            if (--h->RxXferCount == 0) {
+                h->RxState = HAL_UART_STATE_READY;
+                HAL_UART_RxCpltCallback(h);
+            }
+        }
+        if (err) {
+            if (err & USART_SR_PE) h->ErrorCode |= HAL_UART_ERROR_PE;
+            if (err & USART_SR_FE) h->ErrorCode |= HAL_UART_ERROR_FE;
+            if (err & USART_SR_NE) h->ErrorCode |= HAL_UART_ERROR_NE;
+            if (err & USART_SR_ORE) {
+                // ORE はブロッキングエラー: 受信を終了してから通知
+                h->ErrorCode |= HAL_UART_ERROR_ORE;
+                h->RxState = HAL_UART_STATE_READY;
+                p.regs.CR1 = p.regs.CR1 & ~USART_CR1_RXNEIE;
+            }
+            if (p.beforeError) p.beforeError();
+            HAL_UART_ErrorCallback(h);
+            h->ErrorCode = HAL_UART_ERROR_NONE;
+        }
+    }
+    if (h->gState == HAL_UART_STATE_BUSY_TX) {
+        while (h->TxXferCount > 0 && p.fifo.size() < 2) {
+            txLoad(p, *h->pTxBuffPtr++);
+            h->TxXferCount = h->TxXferCount - 1;
+            if (h->hdmatx) h->hdmatx->remaining = h->TxXferCount;
+        }
+        if (h->TxXferCount == 0 && p.fifo.empty()) {
+            h->gState = HAL_UART_STATE_READY;
+            HAL_UART_TxCpltCallback(h);
+        }
+    }
+}
+
+struct IsrScope {
+    uint32_t savedPrimask;
+    uint32_t savedIpsr;
+    explicit IsrScope(uint32_t irq) : savedPrimask(tPrimask), savedIpsr(tIpsr) {
+        gLock.lock();
+        tPrimask = 1;
+        tIpsr = irq;
+        gExclusive = false;     // 例外の出入りで排他モニタはクリアされる
+    }
+    ~IsrScope() {
+        tPrimask = savedPrimask;
+        tIpsr = savedIpsr;
+        gLock.unlock();
+    }
+};
+
+void dispatch()
+{
+    if (tPrimask || tIpsr || gDispatching) return;
+    gDispatching = true;
+    for (int guard = 0; guard < 100000; guard++) {
+        bool ran = false;
+        for (int i = 0; i < 6; i++) {
+            Port& p = gPorts[i];
+            if (!irqPending(p)) continue;
+            if (p.pendingSince != NEVER && gNow - p.pendingSince > gMaxLatency)
+                gMaxLatency = gNow - p.pendingSince;
+            {
+                IsrScope isr(static_cast<uint32_t>(53 + i));
+                if (p.irqHook) p.irqHook();
+                halIrq(p);
+            }
+            p.pendingSince = irqPending(p) ? gNow.load() : NEVER;
+            ran = true;
+        }
+        if (gScb.ICSR & SCB_ICSR_PENDSVSET_Msk) {
+            gScb.ICSR = gScb.ICSR & ~SCB_ICSR_PENDSVSET_Msk;
+            gSoftPending[PendSV_IRQn] = true;
+        }
+        for (auto& e : gSoftPending) {
+            if (!e.second) continue;
+            e.second = false;
+            auto it = gSoftIrq.find(e.first);
+            if (it != gSoftIrq.end() && it->second) {
+                IsrScope isr(14);
+                it->second();
+            }
+            ran = true;
+        }
+        if (!ran) break;
+    }
+    gDispatching = false;
+}
+
+void advanceTo(uint64_t target)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    for (;;) {
+        uint64_t t = nextHwEvent();
+        if (t > target) break;
+        if (t > gNow) gNow = t;
+        hwEvents();
+        dispatch();
+    }
+    if (target > gNow) gNow = target;
+    dispatch();
+}
+
+// レジスタアクセス 1 回分の時間を進める
+void touch()
+{
+    advanceTo(gNow + gRegCost);
+}
+
+} // namespace
+
+/*----------------------------------------
+ * 周辺インスタンス
+ *----------------------------------------*/
+USART_TypeDef* USART1 = &gPorts[0].regs;
+USART_TypeDef* USART2 = &gPorts[1].regs;
+USART_TypeDef* USART3 = &gPorts[2].regs;
+USART_TypeDef* UART4 = &gPorts[3].regs;
+USART_TypeDef* UART5 = &gPorts[4].regs;
+USART_TypeDef* USART6 = &gPorts[5].regs;
+GPIO_TypeDef* GPIOA = &gGpio[0];
+GPIO_TypeDef* GPIOB = &gGpio[1];
+GPIO_TypeDef* GPIOC = &gGpio[2];
+DWT_Type* DWT = &gDwt;
+CoreDebug_Type* CoreDebug = &gCoreDebug;
+SCB_Type* SCB = &gScb;
+uint32_t SystemCoreClock = 168000000u;
+
+UsartStatusReg::operator uint32_t() const
+{
+    touch();
+    return raw;
+}
+
+UsartStatusReg& UsartStatusReg::operator=(uint32_t v)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    raw &= v;
+    return *this;
+}
+
+UsartDataReg::operator uint32_t() const
+{
+    touch();
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    auto usart = reinterpret_cast<const USART_TypeDef*>(
+        reinterpret_cast<const char*>(this) - offsetof(USART_TypeDef, DR));
+    return readDr(*portOf(usart));
+}
+
+GpioInputReg::operator uint32_t() const
+{
+    touch();
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    auto port = reinterpret_cast<GPIO_TypeDef*>(
+        const_cast<char*>(reinterpret_cast<const char*>(this) - offsetof(GPIO_TypeDef, IDR)));
+    uint32_t v = 0;
+    for (int i = 0; i < 16; i++) {
+        uint16_t pin = static_cast<uint16_t>(1u << i);
+        if (sim::pin(port, pin)) v |= pin;
+    }
+    return v;
+}
+
+CycleCounterReg::operator uint32_t() const
+{
+    touch();
+    return static_cast<uint32_t>(gNow * (SystemCoreClock / 1000000u) / 1000u);
+}
+
+/*----------------------------------------
+ * HAL
+ *----------------------------------------*/
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    Port* p = portOf(huart->Instance);
+    if (!p || huart->Init.BaudRate == 0) return HAL_ERROR;
+    p->h = huart;
+    p->baud = huart->Init.BaudRate;
+    p->regs.CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+    p->regs.CR3 = huart->Init.HwFlowCtl;
+    if (p->fifo.empty()) p->regs.SR.raw |= USART_SR_TC | USART_SR_TXE;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef* huart)
+{
+    huart->gState = HAL_UART_STATE_RESET;
+    huart->RxState = HAL_UART_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    if (huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if (!data || size == 0) return HAL_ERROR;
+    huart->pRxBuffPtr = data;
+    huart->RxXferSize = size;
+    huart->RxXferCount = size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->Instance->CR1 = huart->Instance->CR1 | USART_CR1_RXNEIE;
+    markPending();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    if (huart->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if (!data || size == 0) return HAL_ERROR;
+    huart->pTxBuffPtr = data;
+    huart->TxXferSize = size;
+    huart->TxXferCount = size;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    markPending();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size)
+{
+    HAL_StatusTypeDef st = HAL_UART_Transmit_IT(huart, data, size);
+    if (st == HAL_OK && huart->hdmatx) huart->hdmatx->remaining = size;
+    return st;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size, uint32_t)
+{
+    HAL_StatusTypeDef st = HAL_UART_Transmit_IT(huart, data, size);
+    if (st != HAL_OK) return st;
+    while (huart->gState != HAL_UART_STATE_READY) __WFI();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    huart->RxXferCount = 0;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->Instance->CR1 = huart->Instance->CR1 & ~USART_CR1_RXNEIE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef* huart)
+{
+    // DR とシフトレジスタに入ったバイトはそのまま送出される
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    huart->TxXferCount = 0;
+    if (huart->hdmatx) huart->hdmatx->remaining = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef*)
+{
+    // シミュレータが割り込みごとに halIrq() を実行する
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    gPins[{port, pin}].high = (state == GPIO_PIN_SET);
+    gPinWrites.push_back(sim::PinWrite{gNow, port, pin, state == GPIO_PIN_SET});
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin)
+{
+    touch();
+    return sim::pin(port, pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    touch();
+    return static_cast<uint32_t>(gNow / 1000000u);
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) { return SystemCoreClock / 4; }
+uint32_t HAL_RCC_GetPCLK2Freq(void) { return SystemCoreClock / 2; }
+uint32_t HAL_RCC_GetHCLKFreq(void) { return SystemCoreClock; }
+
+void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    gSoftPending[irq] = true;
+}
+
+/*----------------------------------------
+ * CMSIS
+ *----------------------------------------*/
+uint32_t __get_PRIMASK(void) { return tPrimask; }
+uint32_t __get_IPSR(void) { return tIpsr; }
+
+void __disable_irq(void)
+{
+    if (tPrimask) return;
+    gLock.lock();
+    tPrimask = 1;
+    if (!tIpsr) gMaskedSince = gNow;
+}
+
+void __enable_irq(void)
+{
+    if (!tPrimask) return;
+    if (!tIpsr && gNow - gMaskedSince > gMaxMasked) gMaxMasked = gNow - gMaskedSince;
+    tPrimask = 0;
+    dispatch();      // マスク中に保留された割り込みをここで処理
+    gLock.unlock();
+}
+
+void __WFI(void)
+{
+    if (tPrimask || tIpsr) return;
+    uint64_t next;
+    {
+        std::lock_guard<std::recursive_mutex> lock(gLock);
+        next = nextHwEvent();
+    }
+    // 次のハードウェアイベントか SysTick（1 ms）まで眠る
+    uint64_t tick = (gNow / 1000000u + 1) * 1000000u;
+    advanceTo(next < tick ? next : tick);
+}
+
+uint16_t __LDREXH(volatile uint16_t* p)
+{
+    gExclusive = true;
+    return *p;
+}
+
+uint32_t __STREXH(uint16_t v, volatile uint16_t* p)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    if (!gExclusive) return 1;
+    gExclusive = false;
+    *p = v;
+    return 0;
+}
+
+void __CLREX(void) { gExclusive = false; }
+
+/*----------------------------------------
+ * シミュレータ操作
+ *----------------------------------------*/
+namespace sim {
+
+void reset()
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    for (Port& p : gPorts) {
+        p.regs.SR.raw = USART_SR_TC | USART_SR_TXE;
+        p.regs.DR.raw = 0;
+        p.regs.BRR = p.regs.CR1 = p.regs.CR2 = p.regs.CR3 = p.regs.GTPR = 0;
+        p.h = nullptr;
+        p.baud = 0;
+        p.fifo.clear();
+        p.txDoneAt = NEVER;
+        p.peer = nullptr;
+        p.wire.clear();
+        p.irqHook = nullptr;
+        p.beforeError = nullptr;
+        p.source = nullptr;
+        p.sourceNextAt = NEVER;
+        p.rxSinceIdle = false;
+        p.idleAt = NEVER;
+        p.idlePending = false;
+        p.pendingSince = NEVER;
+    }
+    gPins.clear();
+    gPinWrites.clear();
+    gSoftIrq.clear();
+    gSoftPending.clear();
+    gScb.ICSR = 0;
+    gNow = 0;
+    gRegCost = 20;
+    gMaxMasked = 0;
+    gMaxLatency = 0;
+    gBer = 0.0;
+    gRng.seed(1);
+}
+
+uint64_t now() { return gNow; }
+
+uint64_t byteTime(uint32_t baud) { return charTime(baud); }
+
+void run(uint64_t ns) { advanceTo(gNow + ns); }
+
+bool runUntil(const std::function<bool()>& done, uint64_t maxNs, uint64_t stepNs)
+{
+    uint64_t end = gNow + maxNs;
+    while (!done()) {
+        if (gNow >= end) return false;
+        advanceTo(gNow + stepNs);
+    }
+    return true;
+}
+
+void connect(USART_TypeDef* a, USART_TypeDef* b)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    portOf(a)->peer = b;
+    portOf(b)->peer = a;
+}
+
+void setIrqHook(USART_TypeDef* usart, std::function<void()> hook)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    portOf(usart)->irqHook = std::move(hook);
+}
+
+void setBeforeErrorHook(USART_TypeDef* usart, std::function<void()> hook)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    portOf(usart)->beforeError = std::move(hook);
+}
+
+void setRxSource(USART_TypeDef* usart, uint32_t baud, std::function<int()> next)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    Port* p = portOf(usart);
+    p->source = std::move(next);
+    p->sourceBaud = baud;
+    p->sourceNextAt = p->source ? gNow + charTime(baud) : NEVER;
+}
+
+void rxByte(USART_TypeDef* usart, uint8_t b, uint32_t errorFlags)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    rxArrive(*portOf(usart), b, errorFlags);
+    markPending();
+    dispatch();
+}
+
+const std::vector<WireByte>& wire(USART_TypeDef* usart) { return portOf(usart)->wire; }
+
+void clearWire(USART_TypeDef* usart)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    portOf(usart)->wire.clear();
+}
+
+void setBitErrorRate(double ber, uint32_t seed)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    gBer = ber;
+    gRng.seed(seed);
+}
+
+void setPin(GPIO_TypeDef* port, uint16_t pin, bool high)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    gPins[{port, pin}].high = high;
+}
+
+bool pin(GPIO_TypeDef* port, uint16_t pin)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    auto it = gPins.find({port, pin});
+    if (it == gPins.end()) return true;     // 未接続の入力はプルアップ扱い
+    if (it->second.wave) return it->second.wave(gNow);
+    return it->second.high;
+}
+
+void setPinWaveform(GPIO_TypeDef* port, uint16_t pin, std::function<bool(uint64_t)> wave)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    gPins[{port, pin}].wave = std::move(wave);
+}
+
+const std::vector<PinWrite>& pinWrites() { return gPinWrites; }
+
+void isr(const std::function<void()>& fn)
+{
+    {
+        IsrScope scope(1);
+        fn();
+    }
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    markPending();
+    dispatch();
+}
+
+void setSoftIrqHandler(IRQn_Type irq, std::function<void()> handler)
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    gSoftIrq[irq] = std::move(handler);
+}
+
+uint64_t maxMaskedNs() { return gMaxMasked; }
+uint64_t maxIrqLatencyNs() { return gMaxLatency; }
+
+void resetLatencyStats()
+{
+    std::lock_guard<std::recursive_mutex> lock(gLock);
+    gMaxMasked = 0;
+    gMaxLatency = 0;
+    for (Port& p : gPorts) {
+        if (p.pendingSince != NEVER) p.pendingSince = gNow;
+    }
+}
+
+void setRegisterCostNs(uint32_t ns) { gRegCost = ns; }
+
+} // namespace sim
@@ -0,0 +1,159 @@
+#include "task.h"
+#include "sim.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+struct TaskStub {
+    std::condition_variable cv;
+    uint32_t count = 0;          // 通知値
+    bool waiting = false;        // ulTaskNotifyTake() で待機中
+    bool wake = false;           // 通知またはタイムアウトで起床させた
+    uint64_t deadline = 0;       // タイムアウト時刻（ns）
+};
+
+namespace {
+std::mutex gMutex;
+std::condition_variable gBlocked;
+std::vector<TaskStub*> gTasks;
+int gRunning = 0;                // 待機していないタスク数
+uint32_t gWakeups = 0;
+thread_local TaskStub* tCurrent = nullptr;
+thread_local int tCritical = 0;
+
+uint32_t nowTicks()
+{
+    return static_cast<uint32_t>(sim::now() / 1000000u);
+}
+}
+
+/*----------------------------------------
+ * クリティカルセクション
+ *----------------------------------------*/
+void vPortEnterCritical(void)
+{
+    __disable_irq();
+    tCritical++;
+}
+
+void vPortExitCritical(void)
+{
+    if (--tCritical == 0) __enable_irq();
+}
+
+/*----------------------------------------
+ * タスク通知
+ *----------------------------------------*/
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return tCurrent;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    task->count++;
+    if (task->waiting && !task->wake) {
+        task->wake = true;
+        gRunning++;
+        task->cv.notify_one();
+    }
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    TaskStub* self = tCurrent;
+    std::unique_lock<std::mutex> lock(gMutex);
+    if (self->count == 0 && ticksToWait != 0) {
+        self->waiting = true;
+        self->wake = false;
+        self->deadline = (ticksToWait == portMAX_DELAY)
+            ? UINT64_MAX : sim::now() + static_cast<uint64_t>(ticksToWait) * 1000000u;
+        gRunning--;
+        gBlocked.notify_all();
+        self->cv.wait(lock, [self] { return self->wake; });
+        self->waiting = false;
+        if (self->count) gWakeups++;
+    }
+    uint32_t value = self->count;
+    if (clearCountOnExit) self->count = 0;
+    else if (self->count) self->count--;
+    return value;
+}
+
+void vTaskSetTimeOutState(TimeOut_t* timeOut)
+{
+    timeOut->start = nowTicks();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t* timeOut, TickType_t* ticksToWait)
+{
+    if (*ticksToWait == portMAX_DELAY) return pdFALSE;
+    uint32_t now = nowTicks();
+    uint32_t elapsed = now - timeOut->start;
+    if (elapsed >= *ticksToWait) {
+        *ticksToWait = 0;
+        return pdTRUE;
+    }
+    *ticksToWait -= elapsed;
+    timeOut->start = now;
+    return pdFALSE;
+}
+
+/*----------------------------------------
+ * テスト用の制御
+ *----------------------------------------*/
+namespace rtos {
+
+Task::Task()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    tCurrent = new TaskStub;
+    gTasks.push_back(tCurrent);
+    gRunning++;
+}
+
+Task::~Task()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    for (auto it = gTasks.begin(); it != gTasks.end(); ++it) {
+        if (*it == tCurrent) {
+            gTasks.erase(it);
+            break;
+        }
+    }
+    delete tCurrent;
+    tCurrent = nullptr;
+    gRunning--;
+    gBlocked.notify_all();
+}
+
+void waitUntilBlocked()
+{
+    std::unique_lock<std::mutex> lock(gMutex);
+    // シミュレーション時刻でタイムアウトしたタスクを起こす
+    uint64_t now = sim::now();
+    for (TaskStub* t : gTasks) {
+        if (t->waiting && !t->wake && now >= t->deadline) {
+            t->wake = true;
+            gRunning++;
+            t->cv.notify_one();
+        }
+    }
+    gBlocked.wait(lock, [] { return gRunning == 0; });
+}
+
+uint32_t wakeups()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gWakeups;
+}
+
+void resetStats()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    gWakeups = 0;
+}
+
+} // namespace rtos
@@ -0,0 +1,116 @@
+/**
+ * @file sim.hpp
+ * @brief Control interface of the simulated MCU behind the stub HAL.
+ *
+ * Time is simulated in nanoseconds. The USART model shifts bytes out at the
+ * configured baud rate (10 bits per byte), has a one-byte DR plus the shift
+ * register on both sides, sets ORE when a byte arrives while RXNE is still
+ * set, and raises IDLE one character time after the last received byte.
+ * Interrupts are dispatched only when the calling thread has not masked them
+ * (__disable_irq()), so the time spent masked shows up as interrupt latency.
+ *
+ * Thread context advances time with run(), __WFI(), HAL_GetTick() and every
+ * read of a peripheral register.
+ */
+
+#ifndef STM32BS_TEST_SIM_HPP
+#define STM32BS_TEST_SIM_HPP
+
+#include "stm32f4xx_hal.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace sim {
+
+/** @brief One byte that left a TX pin. */
+struct WireByte {
+    uint64_t t;     /**< Time the stop bit ended (ns) */
+    uint8_t b;      /**< Byte value */
+    uint32_t baud;  /**< Baud rate it was sent with */
+};
+
+/** @brief One HAL_GPIO_WritePin() call. */
+struct PinWrite {
+    uint64_t t;           /**< Time of the write (ns) */
+    GPIO_TypeDef* port;   /**< Port */
+    uint16_t pin;         /**< Pin mask */
+    bool high;            /**< New level */
+};
+
+/** @brief Reset time, peripherals, pins and statistics. */
+void reset();
+
+/** @brief Current simulated time in ns. */
+uint64_t now();
+
+/** @brief Simulated time of one 10-bit character at @p baud in ns. */
+uint64_t byteTime(uint32_t baud);
+
+/** @brief Advance time by @p ns, servicing interrupts on the way. */
+void run(uint64_t ns);
+
+/** @brief Advance in steps of @p stepNs until @p done returns true or @p maxNs passed. @return done() */
+bool runUntil(const std::function<bool()>& done, uint64_t maxNs, uint64_t stepNs = 1000);
+
+/** @brief Cross-connect TX / RX of two USARTs (full duplex). */
+void connect(USART_TypeDef* a, USART_TypeDef* b);
+
+/** @brief Body of USARTx_IRQHandler() that runs before HAL_UART_IRQHandler() (e.g. serial.handleIrq()). */
+void setIrqHook(USART_TypeDef* usart, std::function<void()> hook);
+
+/** @brief Called inside the HAL IRQ handler just before HAL_UART_ErrorCallback(). */
+void setBeforeErrorHook(USART_TypeDef* usart, std::function<void()> hook);
+
+/**
+ * @brief Scripted remote transmitter on the RX pin of @p usart.
+ * @p next is asked for a byte once per character time; it returns -1 to
+ * leave the slot idle. Pass nullptr to remove the source.
+ */
+void setRxSource(USART_TypeDef* usart, uint32_t baud, std::function<int()> next);
+
+/** @brief A byte arrives on the RX pin now, with optional error flags (USART_SR_FE, ...). */
+void rxByte(USART_TypeDef* usart, uint8_t b, uint32_t errorFlags = 0);
+
+/** @brief Bytes sent by @p usart so far. */
+const std::vector<WireByte>& wire(USART_TypeDef* usart);
+
+/** @brief Forget the bytes recorded by wire(). */
+void clearWire(USART_TypeDef* usart);
+
+/** @brief Flip each transmitted bit with probability @p ber (all links). */
+void setBitErrorRate(double ber, uint32_t seed = 1);
+
+/** @brief Drive an input pin. */
+void setPin(GPIO_TypeDef* port, uint16_t pin, bool high);
+
+/** @brief Current level of a pin (input or output). */
+bool pin(GPIO_TypeDef* port, uint16_t pin);
+
+/** @brief Drive an input pin from a function of time (nullptr to stop). */
+void setPinWaveform(GPIO_TypeDef* port, uint16_t pin, std::function<bool(uint64_t ns)> wave);
+
+/** @brief All HAL_GPIO_WritePin() calls since reset(). */
+const std::vector<PinWrite>& pinWrites();
+
+/** @brief Run @p fn in interrupt context (IPSR != 0, interrupts masked). */
+void isr(const std::function<void()>& fn);
+
+/** @brief Handler for a software-pended interrupt (PendSV_IRQn or an NVIC line). */
+void setSoftIrqHandler(IRQn_Type irq, std::function<void()> handler);
+
+/** @brief Longest stretch thread code kept interrupts masked (ns). */
+uint64_t maxMaskedNs();
+
+/** @brief Longest time a USART interrupt stayed pending before it was serviced (ns). */
+uint64_t maxIrqLatencyNs();
+
+/** @brief Clear maxMaskedNs() / maxIrqLatencyNs(). */
+void resetLatencyStats();
+
+/** @brief Simulated cost of one peripheral register read (default 20 ns). */
+void setRegisterCostNs(uint32_t ns);
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the parts of the STM32F4 HAL / CMSIS used by the library.
+ *
+ * Registers with read side effects (USART SR / DR, GPIO IDR, DWT CYCCNT) are small
+ * classes that call into the simulator in hal_stub.cpp. Every such read costs a few
+ * nanoseconds of simulated time, so busy-wait loops in the library terminate.
+ * The simulator itself is controlled through sim.hpp.
+ */
+
+#ifndef STM32BS_TEST_STM32F4XX_HAL_H
+#define STM32BS_TEST_STM32F4XX_HAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define __IO volatile
+
+/*----------------------------------------
+ * Registers with side effects
+ *----------------------------------------*/
+struct UsartStatusReg {
+    uint32_t raw;
+    operator uint32_t() const;
+    UsartStatusReg& operator=(uint32_t v);   // rc_w0: writing 0 clears a bit
+};
+
+struct UsartDataReg {
+    uint32_t raw;
+    operator uint32_t() const;               // clears RXNE / IDLE / ORE / NE / FE / PE
+    UsartDataReg& operator=(uint32_t v) { raw = v; return *this; }
+};
+
+typedef struct {
+    UsartStatusReg SR;
+    UsartDataReg DR;
+    __IO uint32_t BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+struct GpioInputReg {
+    operator uint32_t() const;
+};
+
+typedef struct {
+    __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR;
+    GpioInputReg IDR;
+    __IO uint32_t ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+struct CycleCounterReg {
+    operator uint32_t() const;
+};
+
+typedef struct { __IO uint32_t CTRL; CycleCounterReg CYCCNT; } DWT_Type;
+typedef struct { __IO uint32_t DEMCR; } CoreDebug_Type;
+typedef struct { __IO uint32_t ICSR; __IO uint32_t SCR; } SCB_Type;
+
+extern DWT_Type* DWT;
+extern CoreDebug_Type* CoreDebug;
+extern SCB_Type* SCB;
+extern USART_TypeDef *USART1, *USART2, *USART3, *UART4, *UART5, *USART6;
+extern GPIO_TypeDef *GPIOA, *GPIOB, *GPIOC;
+extern uint32_t SystemCoreClock;
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24)
+#define DWT_CTRL_CYCCNTENA_Msk     1u
+#define SCB_ICSR_PENDSVSET_Msk     (1u << 28)
+#define SCB_SCR_SLEEPONEXIT_Msk    (1u << 1)
+
+/*----------------------------------------
+ * HAL types
+ *----------------------------------------*/
+typedef enum { HAL_OK, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+typedef enum {
+    HAL_UART_STATE_RESET = 0x00, HAL_UART_STATE_READY = 0x20, HAL_UART_STATE_BUSY = 0x24,
+    HAL_UART_STATE_BUSY_TX = 0x21, HAL_UART_STATE_BUSY_RX = 0x22
+} HAL_UART_StateTypeDef;
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+typedef int IRQn_Type;
+#define PendSV_IRQn (-2)
+
+typedef struct { uint32_t BaudRate, WordLength, StopBits, Parity, Mode, HwFlowCtl, OverSampling; } UART_InitTypeDef;
+typedef struct { uint32_t remaining; } DMA_HandleTypeDef;
+
+typedef struct {
+    USART_TypeDef* Instance;
+    UART_InitTypeDef Init;
+    const uint8_t* pTxBuffPtr;
+    uint16_t TxXferSize;
+    __IO uint16_t TxXferCount;
+    uint8_t* pRxBuffPtr;
+    uint16_t RxXferSize;
+    __IO uint16_t RxXferCount;
+    DMA_HandleTypeDef* hdmatx;
+    DMA_HandleTypeDef* hdmarx;
+    __IO HAL_UART_StateTypeDef gState;
+    __IO HAL_UART_StateTypeDef RxState;
+    __IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+#define HAL_UART_ERROR_NONE 0x00u
+#define HAL_UART_ERROR_PE   0x01u
+#define HAL_UART_ERROR_NE   0x02u
+#define HAL_UART_ERROR_FE   0x04u
+#define HAL_UART_ERROR_ORE  0x08u
+#define HAL_UART_ERROR_DMA  0x10u
+
+#define USART_SR_PE   (1u << 0)
+#define USART_SR_FE   (1u << 1)
+#define USART_SR_NE   (1u << 2)
+#define USART_SR_ORE  (1u << 3)
+#define USART_SR_IDLE (1u << 4)
+#define USART_SR_RXNE (1u << 5)
+#define USART_SR_TC   (1u << 6)
+#define USART_SR_TXE  (1u << 7)
+#define USART_SR_CTS  (1u << 9)
+
+#define UART_FLAG_PE   USART_SR_PE
+#define UART_FLAG_FE   USART_SR_FE
+#define UART_FLAG_NE   USART_SR_NE
+#define UART_FLAG_ORE  USART_SR_ORE
+#define UART_FLAG_IDLE USART_SR_IDLE
+#define UART_FLAG_RXNE USART_SR_RXNE
+#define UART_FLAG_TC   USART_SR_TC
+#define UART_FLAG_TXE  USART_SR_TXE
+#define UART_FLAG_CTS  USART_SR_CTS
+
+#define USART_CR1_RE     (1u << 2)
+#define USART_CR1_TE     (1u << 3)
+#define USART_CR1_IDLEIE (1u << 4)
+#define USART_CR1_RXNEIE (1u << 5)
+#define USART_CR1_TCIE   (1u << 6)
+#define USART_CR1_TXEIE  (1u << 7)
+#define USART_CR1_UE     (1u << 13)
+#define USART_CR3_RTSE   (1u << 8)
+#define USART_CR3_CTSE   (1u << 9)
+
+#define UART_IT_IDLE USART_CR1_IDLEIE
+#define UART_IT_TC   USART_CR1_TCIE
+
+#define UART_HWCONTROL_NONE    0u
+#define UART_HWCONTROL_RTS     USART_CR3_RTSE
+#define UART_HWCONTROL_CTS     USART_CR3_CTSE
+#define UART_HWCONTROL_RTS_CTS (USART_CR3_RTSE | USART_CR3_CTSE)
+#define UART_OVERSAMPLING_16   0u
+#define UART_OVERSAMPLING_8    (1u << 15)
+#define UART_WORDLENGTH_8B     0u
+#define UART_WORDLENGTH_9B     (1u << 12)
+#define UART_STOPBITS_1        0u
+#define UART_PARITY_NONE       0u
+#define UART_PARITY_EVEN       (1u << 10)
+#define UART_MODE_TX_RX        (USART_CR1_TE | USART_CR1_RE)
+
+#define __HAL_UART_GET_FLAG(h, f) ((((h)->Instance->SR) & (f)) == (f))
+#define __HAL_UART_CLEAR_FLAG(h, f) ((h)->Instance->SR = ~(f))
+#define __HAL_UART_CLEAR_PEFLAG(h) \
+    do { volatile uint32_t t_ = (h)->Instance->SR; t_ = (h)->Instance->DR; (void)t_; } while (0)
+#define __HAL_UART_CLEAR_OREFLAG(h)  __HAL_UART_CLEAR_PEFLAG(h)
+#define __HAL_UART_CLEAR_IDLEFLAG(h) __HAL_UART_CLEAR_PEFLAG(h)
+#define __HAL_UART_ENABLE_IT(h, i)  ((h)->Instance->CR1 = (h)->Instance->CR1 | (i))
+#define __HAL_UART_DISABLE_IT(h, i) ((h)->Instance->CR1 = (h)->Instance->CR1 & ~(i))
+#define __HAL_LOCK(h)   do {} while (0)
+#define __HAL_UNLOCK(h) do {} while (0)
+#define __HAL_DMA_GET_COUNTER(h) ((h)->remaining)
+
+#define HAL_MAX_DELAY 0xFFFFFFFFu
+
+/*----------------------------------------
+ * HAL functions (hal_stub.cpp)
+ *----------------------------------------*/
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef* huart);
+void HAL_UART_IRQHandler(UART_HandleTypeDef* huart);
+
+extern "C" void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart);
+extern "C" void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart);
+extern "C" void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart);
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+
+/*----------------------------------------
+ * CMSIS core intrinsics
+ *----------------------------------------*/
+uint32_t __get_PRIMASK(void);
+uint32_t __get_IPSR(void);
+void __disable_irq(void);
+void __enable_irq(void);
+void __WFI(void);
+inline void __DSB(void) {}
+uint16_t __LDREXH(volatile uint16_t* p);
+uint32_t __STREXH(uint16_t v, volatile uint16_t* p);
+void __CLREX(void);
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for the FreeRTOS task notification API (rtos_stub.cpp).
+ */
+
+#ifndef STM32BS_TEST_TASK_H
+#define STM32BS_TEST_TASK_H
+
+#include "FreeRTOS.h"
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+void vTaskSetTimeOutState(TimeOut_t* timeOut);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t* timeOut, TickType_t* ticksToWait);
+
+namespace rtos {
+
+/** @brief Marks the calling thread as a FreeRTOS task for its lifetime. */
+class Task {
+public:
+    Task();
+    ~Task();
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+};
+
+/** @brief Block until every task is waiting in ulTaskNotifyTake() or has finished. */
+void waitUntilBlocked();
+
+/** @brief Number of times ulTaskNotifyTake() returned because of a notification. */
+uint32_t wakeups();
+
+/** @brief Clear wakeups(). */
+void resetStats();
+
+} // namespace rtos
+
+#endif
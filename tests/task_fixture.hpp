@@ -0,0 +1,51 @@
+/**
+ * @file task_fixture.hpp
+ * @brief Run one FreeRTOS-style task (a thread) against the simulated clock.
+ */
+
+#ifndef STM32BS_TEST_TASK_FIXTURE_HPP
+#define STM32BS_TEST_TASK_FIXTURE_HPP
+
+#include "sim.hpp"
+#include "task.h"
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief Run @p body as a task while this thread advances time in @p stepNs steps.
+ * Time only moves while the task is blocked in ulTaskNotifyTake() (or when it reads a
+ * register itself), so a woken task runs "instantly" at the time it was notified.
+ * @return true if the task finished within @p maxNs of simulated time.
+ */
+template <typename Body>
+bool runTask(Body body, uint64_t maxNs, uint64_t stepNs = 1000)
+{
+    std::atomic<bool> started{false};
+    std::atomic<bool> done{false};
+    std::thread thread([&] {
+        rtos::Task task;
+        started = true;
+        body();
+        done = true;
+    });
+    while (!started) std::this_thread::yield();
+
+    uint64_t end = sim::now() + maxNs;
+    for (;;) {
+        rtos::waitUntilBlocked();
+        if (done || sim::now() >= end) break;
+        sim::run(stepNs);
+    }
+    bool finished = done;
+    if (!finished) {
+        // 打ち切り: タイムアウトまで時間を進めてタスクを終わらせる
+        while (!done) {
+            sim::run(1000000);
+            rtos::waitUntilBlocked();
+        }
+    }
+    thread.join();
+    return finished;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file test.hpp
+ * @brief Minimal test registry and assertions for the host tests.
+ *
+ * @code
+ * TEST(ring_keeps_order) {
+ *     CHECK_EQ(serial.read(), 'a');
+ * }
+ * @endcode
+ * Each test executable links test_main.cpp, which resets the simulator
+ * before every test and returns non-zero if any check failed.
+ */
+
+#ifndef STM32BS_TEST_TEST_HPP
+#define STM32BS_TEST_TEST_HPP
+
+#include <cstdio>
+#include <string>
+
+namespace test {
+
+struct Case {
+    const char* name;
+    void (*fn)();
+    Case* next;
+};
+
+/** @brief Register a test case (used by TEST()). */
+int add(Case* c);
+
+/** @brief Record a failed check. */
+void fail(const char* file, int line, const char* expr);
+
+/** @brief Number of failed checks in the current test. */
+int failures();
+
+/** @brief Print a value compared by CHECK_EQ(). */
+template <typename T>
+void print(const T& v) { std::printf("%lld", static_cast<long long>(v)); }
+inline void print(double v) { std::printf("%g", v); }
+inline void print(const std::string& v) { std::printf("\"%s\"", v.c_str()); }
+
+} // namespace test
+
+#define TEST(name)                                                        \
+    static void test_##name();                                            \
+    static test::Case test_case_##name{#name, &test_##name, nullptr};     \
+    static int test_reg_##name = test::add(&test_case_##name);            \
+    static void test_##name()
+
+#define CHECK(expr)                                                       \
+    do {                                                                  \
+        if (!(expr)) test::fail(__FILE__, __LINE__, #expr);               \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                    \
+    do {                                                                  \
+        auto va_ = (a);                                                   \
+        auto vb_ = (b);                                                   \
+        if (!(va_ == vb_)) {                                              \
+            test::fail(__FILE__, __LINE__, #a " == " #b);                 \
+            std::printf("    ");                                          \
+            test::print(va_);                                             \
+            std::printf(" != ");                                          \
+            test::print(vb_);                                             \
+            std::printf("\n");                                            \
+        }                                                                 \
+    } while (0)
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file test_arduino.cpp
+ * @brief STM32BufferedSerialArduino: Stream semantics of available() and the buffered reads.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerialArduino.hpp"
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+
+void receive(const char* s)
+{
+    for (; *s; s++) sim::rxByte(USART2, static_cast<uint8_t>(*s));
+}
+
+} // namespace
+
+// available() は有無ではなく読めるバイト数を返す
+TEST(available_returns_byte_count)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    STM32BufferedSerialArduino port(serial);
+
+    CHECK_EQ(port.available(), 0);
+    receive("hello");
+    CHECK_EQ(port.available(), 5);
+    CHECK_EQ(port.peek(), 'h');
+    CHECK_EQ(port.available(), 5);
+    CHECK_EQ(port.read(), 'h');
+    CHECK_EQ(port.available(), 4);
+}
+
+TEST(read_bytes_until_terminator)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    STM32BufferedSerialArduino port(serial);
+    port.setTimeout(5);
+
+    receive("$GPGGA,1*7\r\nrest");
+    char line[32] = {};
+    size_t n = port.readBytesUntil('\n', line, sizeof(line));
+    CHECK_EQ(n, 11u);
+    CHECK_EQ(std::memcmp(line, "$GPGGA,1*7\r", 11), 0);
+    CHECK_EQ(port.available(), 4);
+}
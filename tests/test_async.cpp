@@ -0,0 +1,167 @@
+/**
+ * @file test_async.cpp
+ * @brief AsyncSerial / AsyncScheduler: ISR completion, partial writes, reads larger than the
+ *        THROTTLE high watermark and pool sizing (built once per policy).
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerialAsync.hpp"
+#include <cstring>
+#include <string>
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint16_t RTS_PIN = GPIO_PIN_1;
+
+// 指定バイト列を送る相手側（RTS が High の間は 2 バイト送ってから止まる）
+struct Sender {
+    const uint8_t* data;
+    uint32_t len;
+    uint32_t next = 0;
+    uint32_t pausedFor = 0;
+
+    int operator()() {
+        if (next >= len) return -1;
+        if (sim::pin(GPIOA, RTS_PIN)) {
+            if (pausedFor >= 2) return -1;
+            pausedFor++;
+        } else {
+            pausedFor = 0;
+        }
+        return data[next++];
+    }
+};
+
+// 準備できたコルーチンを回しながら時間を進める
+bool pump(AsyncScheduler& scheduler, const std::function<bool()>& done, uint64_t maxNs)
+{
+    return sim::runUntil([&] {
+        while (scheduler.runOnce()) {}
+        return done();
+    }, maxNs, sim::byteTime(BAUD));
+}
+
+AsyncTask echoLines(AsyncSerial& port, int count, int& lines)
+{
+    uint8_t line[32];
+    while (lines < count) {
+        uint16_t n = co_await port.readUntil(line, sizeof(line), '\n');
+        co_await port.writeAsync({line, n});
+        lines++;
+    }
+}
+
+AsyncTask writeAll(AsyncSerial& port, const uint8_t* data, uint16_t len, uint16_t& sent, bool& done)
+{
+    sent = co_await port.writeAsync({data, len});
+    done = true;
+}
+
+AsyncTask readAll(AsyncSerial& port, uint8_t* buf, uint16_t len, uint16_t& got, bool& done)
+{
+    got = co_await port.readAsync(buf, len);
+    done = true;
+}
+
+AsyncTask countRuns(int& runs)
+{
+    runs++;
+    co_return;
+}
+
+} // namespace
+
+// 区切り文字で起こされ、読んだ行をそのまま返す
+TEST(read_until_and_write_echo)
+{
+    Uart uart(USART2, BAUD), peerUart(USART1, BAUD);
+    sim::connect(USART1, USART2);
+    STM32BufferedSerial serial(&uart.h, 64), peer(&peerUart.h, 64);
+    serial.begin();
+    peer.begin();
+
+    AsyncScheduler scheduler;
+    AsyncSerial port(serial, scheduler);
+    port.begin();
+    int lines = 0;
+    CHECK(scheduler.spawn(echoLines(port, 2, lines)));
+
+    peer.write(reinterpret_cast<const uint8_t*>("hello\nworld\n"), 12);
+    std::string echoed;
+    CHECK(pump(scheduler, [&] {
+        int c;
+        while ((c = peer.read()) >= 0) echoed.push_back(static_cast<char>(c));
+        return lines == 2 && echoed.size() == 12;
+    }, sim::byteTime(BAUD) * 200));
+    CHECK_EQ(echoed, std::string("hello\nworld\n"));
+}
+
+// TX バッファより長い書き込みは、送信完了のたびに続きを詰めて最後に 1 回だけ再開する
+TEST(write_larger_than_tx_buffer)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    AsyncScheduler scheduler;
+    AsyncSerial port(serial, scheduler);
+    port.begin();
+
+    uint8_t data[300];
+    for (int i = 0; i < 300; i++) data[i] = static_cast<uint8_t>(i);
+    uint16_t sent = 0;
+    bool done = false;
+    CHECK(scheduler.spawn(writeAll(port, data, sizeof(data), sent, done)));
+    CHECK(pump(scheduler, [&] { return sim::wire(USART2).size() == sizeof(data); },
+               sim::byteTime(BAUD) * 400));
+    CHECK(done);
+    CHECK_EQ(sent, 300);
+    bool same = true;
+    for (int i = 0; i < 300; i++) same = same && sim::wire(USART2)[i].b == data[i];
+    CHECK(same);
+}
+
+// リングのハイウォーターマークを超える読み出しも、THROTTLE で相手が止まったまま待ち続けない
+TEST(read_larger_than_high_watermark)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    serial.setRtsPin(GPIOA, RTS_PIN);
+
+    AsyncScheduler scheduler;
+    AsyncSerial port(serial, scheduler);
+    port.begin();
+
+    static uint8_t data[200];
+    for (int i = 0; i < 200; i++) data[i] = static_cast<uint8_t>(i * 7);
+    Sender sender{data, 200};
+    sim::setRxSource(USART2, BAUD, [&] { return sender(); });
+
+    static uint8_t dst[200];
+    uint16_t got = 0;
+    bool done = false;
+    CHECK(scheduler.spawn(readAll(port, dst, sizeof(dst), got, done)));
+    CHECK(pump(scheduler, [&] { return done; }, sim::byteTime(BAUD) * 400));
+    CHECK_EQ(got, 200);
+    CHECK(std::memcmp(dst, data, sizeof(dst)) == 0);
+    CHECK_EQ(serial.getRxDropped(), 0u);
+}
+
+// フレームプールを使い切っても、レディキューが先に溢れることはない
+TEST(ready_queue_holds_every_frame)
+{
+    AsyncScheduler scheduler;
+    int runs = 0;
+    for (int i = 0; i < STM32BS_ASYNC_FRAMES; i++) CHECK(scheduler.spawn(countRuns(runs)));
+    // プールが尽きているので生成に失敗する
+    CHECK(!scheduler.spawn(countRuns(runs)));
+    while (scheduler.runOnce()) {}
+    CHECK_EQ(runs, STM32BS_ASYNC_FRAMES);
+    // 終わったフレームは返却されている
+    CHECK(scheduler.spawn(countRuns(runs)));
+    CHECK(scheduler.runOnce());
+    CHECK_EQ(runs, STM32BS_ASYNC_FRAMES + 1);
+}
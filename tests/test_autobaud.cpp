@@ -0,0 +1,107 @@
+/**
+ * @file test_autobaud.cpp
+ * @brief autoBaud() on F4 (DWT timing of the RX pin): detection, first byte, and how long interrupts stay masked.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <vector>
+
+namespace {
+
+// RX ピンに @p starts の各時刻から @p b を 1 フレームずつ流す波形（8N1、LSB ファースト）
+std::function<bool(uint64_t)> frames(uint8_t b, uint32_t baud, std::vector<uint64_t> starts)
+{
+    return [=](uint64_t t) {
+        for (uint64_t start : starts) {
+            if (t < start) continue;
+            uint64_t bit = (t - start) * baud / 1000000000ull;
+            if (bit == 0) return false;
+            if (bit <= 8) return ((b >> (bit - 1)) & 1) != 0;
+        }
+        return true;
+    };
+}
+
+} // namespace
+
+// スタートビットを待つ間は割り込みを止めず、禁止するのは 1 フレームの計測中だけ
+TEST(detects_rate_and_masks_one_frame_only)
+{
+    Uart uart(USART2, 9600), other(USART1, 115200);
+    STM32BufferedSerial serial(&uart.h, 64), busy(&other.h, 64);
+    busy.begin();
+
+    const uint64_t frame = sim::byteTime(115200);
+    sim::setPinWaveform(GPIOA, GPIO_PIN_3, frames('U', 115200, {sim::now() + 20 * frame}));
+    // 待っている間も別の USART の送信割り込みは処理される
+    const uint8_t bulk[16] = {};
+    busy.write(bulk, sizeof(bulk));
+    sim::resetLatencyStats();
+
+    STM32BufferedSerial::AutoBaudResult r = serial.autoBaud(GPIOA, GPIO_PIN_3, 100);
+    CHECK(r.ok);
+    CHECK_EQ(r.baud, 115200u);
+    CHECK(r.errorPercent > -3.0f && r.errorPercent < 3.0f);
+    CHECK_EQ(uart.h.Init.BaudRate, 115200u);
+    CHECK_EQ(serial.read(), 'U');
+    CHECK(sim::maxMaskedNs() < frame + frame / 2);
+    CHECK(sim::maxIrqLatencyNs() < frame);
+    CHECK_EQ(sim::wire(USART1).size(), sizeof(bulk));
+}
+
+// 割り込みが頻繁でも測定は正しく、立ち下がりを見逃したフレームは次のフレームで測り直す
+TEST(detects_rate_under_interrupt_load)
+{
+    Uart uart(USART2, 9600), other(USART1, 2000000);
+    STM32BufferedSerial serial(&uart.h, 64), busy(&other.h, 256);
+    busy.begin();
+
+    const uint64_t frame = sim::byteTime(57600);
+    std::vector<uint64_t> starts;
+    for (int i = 0; i < 4; i++) starts.push_back(sim::now() + (5 + 3 * i) * frame);
+    sim::setPinWaveform(GPIOA, GPIO_PIN_3, frames('\r', 57600, starts));
+    // 1 回 3 us かかる割り込みが 5 us ごとに入る
+    sim::setIrqHook(USART1, [] { sim::run(3000); });
+    const uint8_t bulk[255] = {};
+    busy.write(bulk, sizeof(bulk));
+    sim::resetLatencyStats();
+
+    STM32BufferedSerial::AutoBaudResult r = serial.autoBaud(GPIOA, GPIO_PIN_3, 100);
+    CHECK(r.ok);
+    CHECK_EQ(r.baud, 57600u);
+    CHECK_EQ(serial.read(), '\r');
+    CHECK(sim::maxMaskedNs() < frame + frame / 2);
+}
+
+// フレームが来なければタイムアウトし、その間も割り込みは止めない
+TEST(times_out_without_masking)
+{
+    Uart uart(USART2, 9600);
+    STM32BufferedSerial serial(&uart.h, 64);
+    sim::resetLatencyStats();
+
+    uint64_t t0 = sim::now();
+    STM32BufferedSerial::AutoBaudResult r = serial.autoBaud(GPIOA, GPIO_PIN_3, 5);
+    CHECK(!r.ok);
+    CHECK(sim::now() - t0 >= 5000000u);
+    CHECK(sim::maxMaskedNs() < 10000u);
+}
+
+// ブレーク（Low のまま）では最低速度の 1 フレーム分で計測を諦め、割り込みを止め続けない
+TEST(break_aborts_capture_after_one_slow_frame)
+{
+    Uart uart(USART2, 9600);
+    STM32BufferedSerial serial(&uart.h, 64);
+    const uint64_t lowFrom = sim::now() + sim::byteTime(115200) * 5;
+    sim::setPinWaveform(GPIOA, GPIO_PIN_3, [=](uint64_t t) { return t < lowFrom; });
+    sim::resetLatencyStats();
+
+    STM32BufferedSerial::AutoBaudResult r = serial.autoBaud(GPIOA, GPIO_PIN_3, 1000);
+    CHECK(!r.ok);
+    const uint64_t slowFrame = sim::byteTime(300);
+    std::printf("  masked %.1f ms (limit %.1f ms)\n", sim::maxMaskedNs() / 1e6, slowFrame / 1e6);
+    CHECK(sim::maxMaskedNs() <= slowFrame + slowFrame / 100);
+    CHECK(sim::now() - lowFrom < 2 * slowFrame);
+}
@@ -0,0 +1,176 @@
+/**
+ * @file test_log.cpp
+ * @brief STM32BS_LOG(): record framing, call sites in inline / template code, and a
+ *        capture for the host decoder round trip (see logdecode_check.cmake).
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include "Crc16.hpp"
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t BAUD = 1000000;
+
+std::vector<uint8_t> wireBytes()
+{
+    std::vector<uint8_t> v;
+    for (const sim::WireByte& w : sim::wire(USART2)) v.push_back(w.b);
+    return v;
+}
+
+void drain(STM32BufferedSerial& serial)
+{
+    sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * 2000, sim::byteTime(BAUD));
+}
+
+uint16_t recordId(const std::vector<uint8_t>& w, size_t at)
+{
+    return static_cast<uint16_t>(w[at + 2] | (w[at + 3] << 8));
+}
+
+// インライン関数・テンプレート内の呼び出し（以前はセクションの競合でビルドできなかった）
+inline void logFromInline(STM32BufferedSerial& serial, int v)
+{
+    STM32BS_LOG(serial, "inline %d", v);
+}
+
+template <typename T>
+void logFromTemplate(STM32BufferedSerial& serial, T v)
+{
+    STM32BS_LOG(serial, "template %" PRIu32, static_cast<uint32_t>(v));
+}
+
+struct Sensor {
+    template <int N>
+    void report(STM32BufferedSerial& serial, float t) { STM32BS_LOG(serial, "sensor %d t=%.2f", N, t); }
+};
+
+} // namespace
+
+TEST(record_layout_and_crc)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 256);
+    serial.begin();
+
+    STM32BS_LOG(serial, "v=%u s=%s", 0x01020304u, "ab");
+    drain(serial);
+    std::vector<uint8_t> w = wireBytes();
+    // 同期 + 長さ + ID 2 + 引数 4 + 文字列 1+2 + CRC 2
+    CHECK_EQ(w.size(), 1u + 1u + 2u + 4u + 3u + 2u);
+    CHECK_EQ(w[0], STM32BufferedSerial::LOG_SYNC);
+    CHECK_EQ(w[1], 2 + 4 + 3);
+    CHECK_EQ(w[4], 0x04);
+    CHECK_EQ(w[7], 0x01);
+    CHECK_EQ(w[8], 2);
+    CHECK_EQ(w[9], 'a');
+    uint16_t crc = crc16Modbus(&w[1], w[1] + 1);
+    CHECK_EQ(w[w.size() - 2], crc & 0xFF);
+    CHECK_EQ(w[w.size() - 1], crc >> 8);
+}
+
+TEST(inline_and_template_call_sites)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 256);
+    serial.begin();
+
+    Sensor sensor;
+    logFromInline(serial, 1);        // 6 + 4 バイト
+    logFromTemplate(serial, 2u);     // 6 + 4
+    logFromTemplate(serial, 3ull);   // 6 + 4（別の実体化）
+    sensor.report<1>(serial, 1.5f);  // 6 + 4 + 4
+    drain(serial);
+    std::vector<uint8_t> w = wireBytes();
+    CHECK_EQ(w.size(), 10u + 10u + 10u + 14u);
+    uint16_t inl = recordId(w, 0), t1 = recordId(w, 10), t2 = recordId(w, 20), s1 = recordId(w, 30);
+    CHECK(inl != t1);
+    CHECK(t1 != s1);
+    // 同じテンプレートの別の実体化は同じ書式文字列を使う
+    CHECK_EQ(t1, t2);
+}
+
+// 入りきらないレコードは丸ごと捨てる（途中までのレコードを送らない）
+TEST(record_dropped_whole_when_full)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 32);
+    serial.begin();
+    serial.setCtsPin(GPIOA, GPIO_PIN_0);
+    sim::setPin(GPIOA, GPIO_PIN_0, true);
+
+    const uint8_t filler[22] = {};
+    serial.write(filler, sizeof(filler));
+    CHECK_EQ(serial.writable_len(), 9);
+    // 6 + 4 = 10 バイトは入らない
+    STM32BS_LOG(serial, "x=%d", 1);
+    CHECK_EQ(serial.writable_len(), 9);
+    // 6 + 0 = 6 バイトは入る
+    STM32BS_LOG(serial, "tick");
+    CHECK_EQ(serial.writable_len(), 3);
+}
+
+// ホスト側デコーダ用のキャプチャ。レコードの間にゴミと壊れたレコードを混ぜ、
+// デコーダが正しいレコードだけを復元できることを logdecode_check.cmake で確かめる
+TEST(round_trip_capture)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 256);
+    serial.begin();
+
+    std::vector<uint8_t> capture;
+    std::string expected;
+    auto take = [&](const char* text) {
+        drain(serial);
+        std::vector<uint8_t> w = wireBytes();
+        capture.insert(capture.end(), w.begin(), w.end());
+        sim::clearWire(USART2);
+        if (text) expected += std::string(text) + "\n";
+        return w;
+    };
+
+    STM32BS_LOG(serial, "boot v%d.%d", 1, 2);
+    take("boot v1.2");
+    // 同期バイトを含むゴミ
+    capture.insert(capture.end(), {0x00, 0xA5, 0x03, 0xA5, 0xFF, 0x10});
+    STM32BS_LOG(serial, "adc=%u t=%.1f", 1234u, 21.5f);
+    take("adc=1234 t=21.5");
+    // 1 バイト化けたレコードは捨てられる
+    STM32BS_LOG(serial, "lost %d", 7);
+    std::vector<uint8_t> bad = take(nullptr);
+    capture[capture.size() - bad.size() + 5] ^= 0x40;
+    STM32BS_LOG(serial, "neg=%d big=%lld hex=%08x", -5, -9000000000LL, 0xBEEFu);
+    take("neg=-5 big=-9000000000 hex=0000beef");
+    // 先頭が欠けたレコード（途中から受信し始めた場合）
+    STM32BS_LOG(serial, "partial %d", 1);
+    bad = take(nullptr);
+    capture.erase(capture.end() - static_cast<long>(bad.size()), capture.end() - static_cast<long>(bad.size()) + 2);
+    STM32BS_LOG(serial, "name=%s ch=%c w=%*d", "pump", 'Z', 4, 42);
+    take("name=pump ch=Z w=  42");
+    logFromInline(serial, -1);
+    take("inline -1");
+    logFromTemplate(serial, 99u);
+    take("template 99");
+    Sensor sensor;
+    sensor.report<3>(serial, -0.25f);
+    take("sensor 3 t=-0.25");
+
+    FILE* f = std::fopen("log_capture.bin", "wb");
+    CHECK(f != nullptr);
+    if (f) {
+        std::fwrite(capture.data(), 1, capture.size(), f);
+        std::fclose(f);
+    }
+    f = std::fopen("log_expected.txt", "w");
+    CHECK(f != nullptr);
+    if (f) {
+        std::fputs(expected.c_str(), f);
+        std::fclose(f);
+    }
+}
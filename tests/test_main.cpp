@@ -0,0 +1,45 @@
+#include "test.hpp"
+#include "sim.hpp"
+#include <cstring>
+
+namespace {
+test::Case* gFirst = nullptr;
+test::Case** gLast = &gFirst;
+int gFailures = 0;
+}
+
+int test::add(Case* c)
+{
+    // 登録順（ファイル内の記述順）に実行する
+    *gLast = c;
+    gLast = &c->next;
+    return 0;
+}
+
+void test::fail(const char* file, int line, const char* expr)
+{
+    std::printf("  %s:%d: CHECK(%s) failed\n", file, line, expr);
+    gFailures++;
+}
+
+int test::failures()
+{
+    return gFailures;
+}
+
+int main(int argc, char** argv)
+{
+    int failed = 0, run = 0;
+    for (test::Case* c = gFirst; c; c = c->next) {
+        if (argc > 1 && std::strcmp(argv[1], c->name) != 0) continue;
+        sim::reset();
+        gFailures = 0;
+        std::printf("[ RUN  ] %s\n", c->name);
+        c->fn();
+        std::printf("[ %s ] %s\n", gFailures ? "FAIL" : " OK ", c->name);
+        if (gFailures) failed++;
+        run++;
+    }
+    std::printf("%d/%d passed\n", run - failed, run);
+    return (failed || run == 0) ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file test_modbus.cpp
+ * @brief ModbusRtu slave against a ModbusRtu master over a simulated link (115200 baud and 1 Mbaud).
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include "ModbusRtu.hpp"
+
+namespace {
+
+constexpr uint8_t SLAVE = 0x11;
+
+// USART1 = マスター、USART2 = スレーブ
+struct Bus {
+    Uart masterUart;
+    Uart slaveUart;
+    STM32BufferedSerial masterSerial;
+    STM32BufferedSerial slaveSerial;
+    ModbusRtu master;
+    ModbusRtu slave;
+    uint16_t holding[64];
+    uint16_t input[16];
+
+    Bus(uint32_t baud, uint16_t slaveBuf = 256)
+        : masterUart(USART1, baud), slaveUart(USART2, baud),
+          masterSerial(&masterUart.h, 256), slaveSerial(&slaveUart.h, slaveBuf),
+          master(masterSerial), slave(slaveSerial), holding(), input()
+    {
+        sim::connect(USART1, USART2);
+        sim::setIrqHook(USART1, [this] { masterSerial.handleIrq(); });
+        sim::setIrqHook(USART2, [this] { slaveSerial.handleIrq(); });
+        masterSerial.begin();
+        slaveSerial.begin();
+        master.begin();
+        slave.begin();
+        for (uint16_t i = 0; i < 64; i++) holding[i] = static_cast<uint16_t>(0x1000 + i);
+        for (uint16_t i = 0; i < 16; i++) input[i] = static_cast<uint16_t>(0x2000 + i);
+        slave.setSlave(SLAVE, holding, 64, input, 16);
+    }
+
+    // 応答が来るまで両側を回す
+    ModbusRtu::Status wait(uint64_t maxNs = 200000000ull) {
+        sim::runUntil([this] {
+            slave.poll();
+            master.poll();
+            return master.status() != ModbusRtu::Status::Pending;
+        }, maxNs, 10000);
+        return master.status();
+    }
+};
+
+void transactions(uint32_t baud)
+{
+    Bus bus(baud);
+    const int N = 100;
+    int ok = 0;
+    uint64_t start = sim::now();
+    for (int i = 0; i < N; i++) {
+        uint16_t count = static_cast<uint16_t>(1 + i % 32);
+        uint16_t addr = static_cast<uint16_t>(i % 32);
+        uint16_t dst[32] = {};
+        CHECK(bus.master.readHoldingRegisters(SLAVE, addr, count, dst));
+        if (bus.wait() != ModbusRtu::Status::Ok) continue;
+        bool same = true;
+        for (uint16_t k = 0; k < count; k++) same = same && dst[k] == 0x1000 + addr + k;
+        CHECK(same);
+
+        uint16_t v = static_cast<uint16_t>(i * 7);
+        CHECK(bus.master.writeSingleRegister(SLAVE, 63, v));
+        if (bus.wait() != ModbusRtu::Status::Ok) continue;
+        CHECK_EQ(bus.holding[63], v);
+        ok++;
+    }
+    double sec = (sim::now() - start) / 1e9;
+    std::printf("  %7u baud: %d/%d read+write pairs ok, %.0f transactions/s, CRC errors %u/%u\n",
+                baud, ok, N, 2 * N / sec,
+                static_cast<unsigned>(bus.master.getCrcErrors()),
+                static_cast<unsigned>(bus.slave.getCrcErrors()));
+    CHECK_EQ(ok, N);
+    CHECK_EQ(bus.master.getCrcErrors(), 0u);
+    CHECK_EQ(bus.slave.getCrcErrors(), 0u);
+    CHECK_EQ(bus.slave.getTxErrors(), 0u);
+}
+
+} // namespace
+
+TEST(master_slave_115200) { transactions(115200); }
+
+TEST(master_slave_1M) { transactions(1000000); }
+
+TEST(write_multiple_and_exceptions)
+{
+    Bus bus(115200);
+    uint16_t src[10];
+    for (uint16_t i = 0; i < 10; i++) src[i] = static_cast<uint16_t>(0xA000 + i);
+    CHECK(bus.master.writeMultipleRegisters(SLAVE, 5, src, 10));
+    CHECK(bus.wait() == ModbusRtu::Status::Ok);
+    for (uint16_t i = 0; i < 10; i++) CHECK_EQ(bus.holding[5 + i], src[i]);
+
+    uint16_t dst[4];
+    CHECK(bus.master.readInputRegisters(SLAVE, 14, 4, dst));
+    CHECK(bus.wait() == ModbusRtu::Status::Exception);
+    CHECK_EQ(bus.master.exceptionCode(), 0x02);
+}
+
+// 応答が TX バッファに入り切らなければ何も送らず、マスターはタイムアウトする（途中までのフレームを出さない）
+TEST(slave_response_is_all_or_nothing)
+{
+    Bus bus(115200, 32);   // スレーブの TX は 31 バイトまで
+    uint16_t dst[20];
+    CHECK(bus.master.readHoldingRegisters(SLAVE, 0, 20, dst, 20));   // 応答は 45 バイト
+    CHECK(bus.wait() == ModbusRtu::Status::Timeout);
+    CHECK_EQ(bus.slave.getTxErrors(), 1u);
+    CHECK_EQ(bus.master.getCrcErrors(), 0u);
+    CHECK(sim::wire(USART2).empty());
+
+    // 入る大きさなら応答する
+    CHECK(bus.master.readHoldingRegisters(SLAVE, 0, 8, dst));
+    CHECK(bus.wait() == ModbusRtu::Status::Ok);
+}
+
+// マスターの要求が入らない場合は false を返し、待ち状態にならない
+TEST(master_request_fails_when_tx_full)
+{
+    Bus bus(115200);
+    uint8_t filler[250] = {};
+    __disable_irq();
+    bus.masterSerial.write(filler, sizeof(filler));
+    uint16_t dst[2];
+    CHECK(!bus.master.readHoldingRegisters(SLAVE, 0, 2, dst));
+    __enable_irq();
+    CHECK(bus.master.status() == ModbusRtu::Status::Idle);
+    CHECK_EQ(bus.master.getTxErrors(), 1u);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test_peek.cpp
+ * @brief peek() / peek(offset) / PeekView: indexing and iteration across the RX ring wrap.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <vector>
+
+namespace {
+
+constexpr uint16_t RING = 64;
+
+void receive(uint8_t first, int count)
+{
+    for (int i = 0; i < count; i++) sim::rxByte(USART2, static_cast<uint8_t>(first + i));
+}
+
+} // namespace
+
+// 読み出し位置がリング末尾の手前にある時、折り返しをまたいで正しい順に見える
+TEST(view_and_peek_across_wrap)
+{
+    Uart uart(USART2);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+
+    // 読み出し位置を 50 まで進めてから 30 バイト受信（50..63, 0..15 に入る）
+    receive(0, 50);
+    uint8_t skip[50];
+    CHECK_EQ(serial.read(skip, 50), 50);
+    receive(100, 30);
+
+    STM32BufferedSerial::PeekView v = serial.peekView();
+    CHECK_EQ(v.size(), 30);
+    CHECK(!v.empty());
+    bool same = true;
+    for (uint16_t i = 0; i < 30; i++) {
+        same = same && v[i] == 100 + i;
+        same = same && serial.peek(i) == 100 + i;
+    }
+    CHECK(same);
+    CHECK_EQ(serial.peek(), 100);
+    CHECK_EQ(serial.peek(30), -1);
+
+    std::vector<uint8_t> seen;
+    for (uint8_t b : v) seen.push_back(b);
+    CHECK_EQ(seen.size(), 30u);
+    same = true;
+    for (size_t i = 0; i < seen.size(); i++) same = same && seen[i] == 100 + i;
+    CHECK(same);
+
+    // 何も消費していない
+    CHECK_EQ(serial.readable_len(), 30);
+    CHECK_EQ(serial.read(), 100);
+}
+
+// 作成後に届いたバイトはビューに含まれず、新しいビューには含まれる
+TEST(view_covers_bytes_present_at_creation)
+{
+    Uart uart(USART2);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+
+    receive(0, 60);
+    uint8_t skip[60];
+    CHECK_EQ(serial.read(skip, 60), 60);
+    receive(10, 6);                          // 60..63, 0..1
+
+    STM32BufferedSerial::PeekView v = serial.peekView();
+    receive(16, 4);                          // 2..5
+    CHECK_EQ(v.size(), 6);
+    CHECK_EQ(v[5], 15);
+
+    STM32BufferedSerial::PeekView w = serial.peekView();
+    CHECK_EQ(w.size(), 10);
+    CHECK_EQ(w[4], 14);
+    CHECK_EQ(w[9], 19);
+    CHECK_EQ(serial.peek(9), 19);
+}
+
+// 空のバッファ
+TEST(empty_view)
+{
+    Uart uart(USART2);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+
+    STM32BufferedSerial::PeekView v = serial.peekView();
+    CHECK(v.empty());
+    CHECK(v.begin() == v.end());
+    CHECK_EQ(serial.peek(), -1);
+}
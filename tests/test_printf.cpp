@@ -0,0 +1,108 @@
+/**
+ * @file test_printf.cpp
+ * @brief printf() / print() family: output matches the C library, ring wrap and truncation.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+constexpr uint32_t BAUD = 1000000;
+
+// 書いた分が送信し終わるまで進めて、回線に出た文字列を返す
+template <typename F>
+std::string sent(STM32BufferedSerial& serial, F&& fn)
+{
+    sim::clearWire(USART2);
+    fn();
+    sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * 1000, sim::byteTime(BAUD));
+    return wireString(USART2);
+}
+
+#define CHECK_FORMAT(serial, ...)                                           \
+    do {                                                                    \
+        char expect[128];                                                   \
+        std::snprintf(expect, sizeof(expect), __VA_ARGS__);                 \
+        CHECK_EQ(sent(serial, [&] { (serial).printf(__VA_ARGS__); }),       \
+                 std::string(expect));                                      \
+    } while (0)
+
+} // namespace
+
+// 整数・文字列の変換は C ライブラリと同じ結果になる
+TEST(printf_matches_libc)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 256);
+    serial.begin();
+
+    CHECK_FORMAT(serial, "%d|%i|%u", -42, 0, 4000000000u);
+    CHECK_FORMAT(serial, "%5d|%-5d|%05d|%+d|% d", 42, 42, -42, 7, 7);
+    CHECK_FORMAT(serial, "%x|%X|%o|%#x", 0xBEEFu, 0xBEEFu, 8u, 0u);
+    CHECK_FORMAT(serial, "%.3d|%.0d|%8.3d", 5, 0, -5);
+    CHECK_FORMAT(serial, "%hhd|%hu|%ld|%lld|%llu", 300, 70000, -2147483647L - 1, -9000000000000000000LL,
+                 18446744073709551615ULL);
+    CHECK_FORMAT(serial, "%zu|%jd|%td", static_cast<size_t>(123), static_cast<intmax_t>(-7),
+                 static_cast<ptrdiff_t>(-1));
+    CHECK_FORMAT(serial, "%s|%.3s|%6s|%-6s|%c|%%", "abc", "abcdef", "ab", "ab", 'Z');
+    CHECK_FORMAT(serial, "%*d|%-*d|%.*s", 4, 1, 4, 1, 2, "xyz");
+    CHECK_FORMAT(serial, "%.2f|%f|%8.3f|%-8.1f|%+.0f", 3.14159, -2.5, 1.0005, 0.3, 2.4);
+    CHECK_FORMAT(serial, "%.9f|%.1f", 0.123456789, 99.96);
+    // ちょうど中間の値は切り上げ（C ライブラリは偶数丸め）
+    CHECK_EQ(sent(serial, [&] { serial.printf("%.1f|%.0f", 0.25, 2.5); }), std::string("0.3|3"));
+}
+
+TEST(print_family)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 256);
+    serial.begin();
+
+    CHECK_EQ(sent(serial, [&] { serial.print(-123); }), std::string("-123"));
+    CHECK_EQ(sent(serial, [&] { serial.print(255u, 16); }), std::string("FF"));
+    CHECK_EQ(sent(serial, [&] { serial.print(5ul, 2); }), std::string("101"));
+    CHECK_EQ(sent(serial, [&] { serial.print(-1.005, 1); }), std::string("-1.0"));
+    CHECK_EQ(sent(serial, [&] { serial.printFixed(-1234, 2); }), std::string("-12.34"));
+    CHECK_EQ(sent(serial, [&] { serial.printFixed(5, 3); }), std::string("0.005"));
+    CHECK_EQ(sent(serial, [&] { serial.println("ok"); }), std::string("ok\r\n"));
+}
+
+// リングの折り返しをまたいで書ける
+TEST(printf_wraps_around_ring)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    // 書き込み位置をリング末尾の手前まで進める
+    const uint8_t filler[60] = {};
+    sent(serial, [&] { serial.write(filler, sizeof(filler)); });
+    CHECK_FORMAT(serial, "wrap %08x %s", 0x1234abcdu, "done");
+}
+
+// lane 0 に入りきらない分は切り捨て、書いたバイト数を返す
+TEST(printf_truncates_to_free_space)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 32);
+    serial.begin();
+
+    // CTS で送信を止めてから空きを 10 バイトにする
+    serial.setCtsPin(GPIOA, GPIO_PIN_0);
+    sim::setPin(GPIOA, GPIO_PIN_0, true);
+    const uint8_t filler[21] = {};
+    CHECK_EQ(serial.write(filler, sizeof(filler)), 21);
+    CHECK_EQ(serial.writable_len(), 10);
+    int n = serial.printf("%s=%d", "temperature", 25);
+    CHECK_EQ(n, 10);
+    CHECK_EQ(serial.writable_len(), 0);
+    sim::setPin(GPIOA, GPIO_PIN_0, false);
+    serial.handleCtsChange();
+    sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * 100, sim::byteTime(BAUD));
+    CHECK_EQ(wireString(USART2).substr(21), std::string("temperatur"));
+}
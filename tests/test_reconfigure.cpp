@@ -0,0 +1,111 @@
+/**
+ * @file test_reconfigure.cpp
+ * @brief setBaud() / reconfigure(): TX drained first, buffered RX data kept, interrupts restored.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <string>
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+
+std::string readAll(STM32BufferedSerial& serial)
+{
+    std::string s;
+    int c;
+    while ((c = serial.read()) >= 0) s.push_back(static_cast<char>(c));
+    return s;
+}
+
+void drain(STM32BufferedSerial& serial)
+{
+    sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * 200, sim::byteTime(BAUD));
+}
+
+} // namespace
+
+// 速度変更の前後で受信済みデータは失われず、送信待ちのデータは古い速度で送り切る
+TEST(set_baud_keeps_rx_and_drains_tx)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    for (char c : std::string("abc")) sim::rxByte(USART2, static_cast<uint8_t>(c));
+    serial.write(reinterpret_cast<const uint8_t*>("0123456789"), 10);
+    CHECK(serial.setBaud(230400));
+    CHECK_EQ(uart.h.Init.BaudRate, 230400u);
+    CHECK_EQ(sim::wire(USART2).size(), 10u);
+    for (const sim::WireByte& w : sim::wire(USART2)) CHECK_EQ(w.baud, BAUD);
+
+    // 受信は新しい速度でそのまま続く
+    sim::rxByte(USART2, 'd');
+    sim::run(sim::byteTime(230400));
+    CHECK_EQ(readAll(serial), std::string("abcd"));
+
+    sim::clearWire(USART2);
+    serial.write(reinterpret_cast<const uint8_t*>("x"), 1);
+    drain(serial);
+    CHECK_EQ(sim::wire(USART2).size(), 1u);
+    CHECK_EQ(sim::wire(USART2)[0].baud, 230400u);
+}
+
+// 16 倍オーバーサンプリングで届かない速度は 8 倍に切り替える（APB1 = 42 MHz）
+TEST(set_baud_selects_oversampling)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    CHECK(serial.setBaud(2000000));
+    CHECK_EQ(uart.h.Init.OverSampling, static_cast<uint32_t>(UART_OVERSAMPLING_16));
+    CHECK(serial.setBaud(3000000));
+    CHECK_EQ(uart.h.Init.OverSampling, static_cast<uint32_t>(UART_OVERSAMPLING_8));
+    CHECK(serial.setBaud(BAUD));
+    CHECK_EQ(uart.h.Init.OverSampling, static_cast<uint32_t>(UART_OVERSAMPLING_16));
+}
+
+// 送信が止まったままならタイムアウトし、設定は変えない
+TEST(set_baud_times_out_when_tx_stalled)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    serial.setCtsPin(GPIOA, GPIO_PIN_0);
+    sim::setPin(GPIOA, GPIO_PIN_0, true);
+
+    serial.write(reinterpret_cast<const uint8_t*>("stuck"), 5);
+    CHECK(!serial.setBaud(9600, 5));
+    CHECK_EQ(uart.h.Init.BaudRate, BAUD);
+
+    sim::setPin(GPIOA, GPIO_PIN_0, false);
+    serial.handleCtsChange();
+    CHECK(serial.setBaud(9600, 5));
+    CHECK_EQ(wireString(USART2), std::string("stuck"));
+}
+
+// HAL_UART_Init() が消すアイドル検出の割り込みを戻す
+TEST(reconfigure_restores_idle_detection)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    sim::setIrqHook(USART2, [&] { serial.handleIrq(); });
+    serial.enableIdleDetection();
+
+    UART_InitTypeDef init = uart.h.Init;
+    init.Parity = UART_PARITY_EVEN;
+    init.WordLength = UART_WORDLENGTH_9B;
+    CHECK(serial.reconfigure(init));
+    CHECK_EQ(uart.h.Init.Parity, static_cast<uint32_t>(UART_PARITY_EVEN));
+    CHECK((USART2->CR1 & USART_CR1_IDLEIE) != 0);
+
+    uint32_t before = serial.getIdleCount();
+    for (char c : std::string("hi")) sim::rxByte(USART2, static_cast<uint8_t>(c));
+    sim::run(sim::byteTime(BAUD) * 3);
+    CHECK_EQ(serial.getIdleCount(), before + 1);
+    CHECK_EQ(readAll(serial), std::string("hi"));
+}
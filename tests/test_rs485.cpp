@@ -0,0 +1,90 @@
+/**
+ * @file test_rs485.cpp
+ * @brief RS-485 DE timing with a GPIO driver enable, and interrupt masking around the guard times.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint8_t GUARD = 16;   // 1 ビット時間
+
+uint64_t guardNs() { return 1000000000ull * GUARD / (16ull * BAUD); }
+
+// DE ピンの変化だけを取り出す
+std::vector<sim::PinWrite> deWrites()
+{
+    std::vector<sim::PinWrite> v;
+    for (const sim::PinWrite& w : sim::pinWrites())
+        if (w.port == GPIOA && w.pin == GPIO_PIN_8) v.push_back(w);
+    return v;
+}
+
+} // namespace
+
+// ハードウェア DE の無い USART では GPIO 指定が必須
+TEST(rejects_hardware_de_without_dem)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    CHECK(!serial.enableRs485({nullptr, 0, GUARD, GUARD, false}));
+    CHECK(serial.enableRs485({GPIOA, GPIO_PIN_8, GUARD, GUARD, false}));
+}
+
+// DE はガード時間を空けて送信を囲み、待ちの間も割り込みは止まらない
+TEST(de_frames_transmission_with_interrupts_enabled)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    CHECK(serial.enableRs485({GPIOA, GPIO_PIN_8, GUARD, GUARD, true}));
+    sim::resetLatencyStats();
+
+    serial.write(reinterpret_cast<const uint8_t*>("hello"), 5);
+    CHECK(sim::runUntil([&] { return serial.drain(0); }, 10000000));
+    sim::run(guardNs() * 2);
+
+    std::vector<sim::PinWrite> de = deWrites();
+    const std::vector<sim::WireByte>& wire = sim::wire(USART2);
+    CHECK_EQ(wireString(USART2), std::string("hello"));
+    CHECK_EQ(de.size(), 3u);   // enableRs485() の Low、送信前の High、送信後の Low
+    if (de.size() == 3 && wire.size() == 5) {
+        CHECK(de[1].high && !de[2].high);
+        uint64_t firstStart = wire.front().t - sim::byteTime(BAUD);
+        CHECK(firstStart >= de[1].t + guardNs());
+        CHECK(de[2].t >= wire.back().t + guardNs());
+        std::printf("  DE lead %.2f us, lag %.2f us, longest masked %.2f us\n",
+                    (firstStart - de[1].t) / 1e3, (de[2].t - wire.back().t) / 1e3,
+                    sim::maxMaskedNs() / 1e3);
+    }
+    // ガード時間（8.7 us）を割り込み禁止のまま待たない
+    CHECK(sim::maxMaskedNs() < guardNs() / 2);
+}
+
+// flushTx() の TC 待ちも割り込みを止めない
+TEST(flush_waits_for_tc_with_interrupts_enabled)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    CHECK(serial.enableRs485({GPIOA, GPIO_PIN_8, GUARD, GUARD, false}));
+
+    serial.write(reinterpret_cast<const uint8_t*>("0123456789"), 10);
+    sim::run(sim::byteTime(BAUD) * 3);
+    sim::resetLatencyStats();
+    serial.flushTx();
+    CHECK(!sim::pin(GPIOA, GPIO_PIN_8));
+    CHECK(sim::maxMaskedNs() < sim::byteTime(BAUD) / 4);
+
+    // 解放後の送信では再び DE を取る
+    serial.write(reinterpret_cast<const uint8_t*>("A"), 1);
+    CHECK(sim::pin(GPIOA, GPIO_PIN_8));
+    CHECK(sim::runUntil([&] { return serial.drain(0); }, 10000000));
+    sim::run(guardNs() * 2);
+    CHECK(!sim::pin(GPIOA, GPIO_PIN_8));
+    CHECK_EQ(wireString(USART2).back(), 'A');
+}
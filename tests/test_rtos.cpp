@@ -0,0 +1,144 @@
+/**
+ * @file test_rtos.cpp
+ * @brief STM32BufferedSerialRtos on the pthread FreeRTOS stand-in: wake-ups, timeouts,
+ *        and requests larger than the THROTTLE high watermark (built once per policy).
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "task_fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include "STM32BufferedSerialRtos.hpp"
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint16_t RTS_PIN = GPIO_PIN_1;
+
+// 指定バイト列を送る相手側（RTS が High の間は 2 バイト送ってから止まる）
+struct Sender {
+    const uint8_t* data;
+    uint32_t len;
+    uint32_t next = 0;
+    uint32_t pausedFor = 0;
+
+    int operator()() {
+        if (next >= len) return -1;
+        if (sim::pin(GPIOA, RTS_PIN)) {
+            if (pausedFor >= 2) return -1;
+            pausedFor++;
+        } else {
+            pausedFor = 0;
+        }
+        return data[next++];
+    }
+};
+
+struct Port {
+    Uart uart;
+    STM32BufferedSerial serial;
+    STM32BufferedSerialRtos rtos;
+
+    Port() : uart(USART2, BAUD), serial(&uart.h, 256), rtos(serial) {
+        serial.begin();
+        serial.setRtsPin(GPIOA, RTS_PIN);
+        rtos.begin();
+    }
+};
+
+} // namespace
+
+// 要求したバイト数が揃った時に 1 回だけ起床する
+TEST(read_wakes_once_per_request)
+{
+    Port port;
+    uint8_t data[64];
+    for (int i = 0; i < 64; i++) data[i] = static_cast<uint8_t>(i);
+    Sender sender{data, 64};
+    sim::setRxSource(USART2, BAUD, [&] { return sender(); });
+    rtos::resetStats();
+
+    uint8_t dst[64] = {};
+    int got = -1;
+    uint64_t returnedAt = 0;
+    CHECK(runTask([&] {
+        got = port.rtos.read(dst, 64, pdMS_TO_TICKS(100));
+        returnedAt = sim::now();
+    }, 100000000));
+
+    CHECK_EQ(got, 64);
+    CHECK_EQ(rtos::wakeups(), 1u);
+    CHECK(memcmp(dst, data, 64) == 0);
+    // 最後のバイトは 64 文字時間後に届く
+    CHECK(returnedAt <= 65 * sim::byteTime(BAUD) + 10000);
+}
+
+// タイムアウト時は届いた分だけ返す
+TEST(read_times_out_with_partial_data)
+{
+    Port port;
+    uint8_t data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    Sender sender{data, 10};
+    sim::setRxSource(USART2, BAUD, [&] { return sender(); });
+
+    uint8_t dst[20];
+    int got = -1;
+    uint64_t returnedAt = 0;
+    CHECK(runTask([&] {
+        got = port.rtos.read(dst, 20, pdMS_TO_TICKS(5));
+        returnedAt = sim::now();
+    }, 100000000, 100000));
+    CHECK_EQ(got, 10);
+    CHECK(returnedAt >= 5000000u && returnedAt < 7000000u);
+}
+
+// ハイウォーターマークを超える要求でも、THROTTLE で相手が止まったまま待ち続けない
+TEST(read_larger_than_high_watermark)
+{
+    Port port;
+    static uint8_t data[600];
+    for (int i = 0; i < 600; i++) data[i] = static_cast<uint8_t>(i * 7);
+    Sender sender{data, 600};
+    sim::setRxSource(USART2, BAUD, [&] { return sender(); });
+
+    static uint8_t dst[600];
+    int got1 = -1, got2 = -1;
+    uint64_t returnedAt = 0;
+    CHECK(runTask([&] {
+        got1 = port.rtos.read(dst, 250, pdMS_TO_TICKS(1000));
+        got2 = port.rtos.read(dst + 250, 350, pdMS_TO_TICKS(1000));
+        returnedAt = sim::now();
+    }, 2000000000ull));
+
+    std::printf("  fill limit %d of %d, 600 bytes in %.1f ms, dropped %u\n",
+                port.serial.rxFillLimit(), port.serial.rxCapacity(), returnedAt / 1e6,
+                static_cast<unsigned>(port.serial.getRxDropped()));
+    CHECK_EQ(got1, 250);
+    CHECK_EQ(got2, 350);
+    CHECK(memcmp(dst, data, 600) == 0);
+    // 回線速度で届く時間（約 52 ms）にわずかな余裕
+    CHECK(returnedAt < 60000000u);
+}
+
+// 区切り文字までが長い行でも同様
+TEST(read_until_longer_than_high_watermark)
+{
+    Port port;
+    static uint8_t data[300];
+    for (int i = 0; i < 300; i++) data[i] = static_cast<uint8_t>('a' + i % 26);
+    data[244] = '\n';
+    Sender sender{data, 300};
+    sim::setRxSource(USART2, BAUD, [&] { return sender(); });
+
+    static uint8_t dst[250];
+    int got = -1;
+    uint64_t returnedAt = 0;
+    CHECK(runTask([&] {
+        got = port.rtos.readUntil(dst, 250, '\n', pdMS_TO_TICKS(1000));
+        returnedAt = sim::now();
+    }, 2000000000ull));
+    CHECK_EQ(got, 245);
+    CHECK(dst[244] == '\n');
+    CHECK(returnedAt < 30000000u);
+}
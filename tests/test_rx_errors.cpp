@@ -0,0 +1,81 @@
+/**
+ * @file test_rx_errors.cpp
+ * @brief handleError(): error counting, error markers and no loss of good bytes.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+
+namespace {
+constexpr uint8_t MARKER = 0xFF;
+}
+
+// 誤りのあるバイトの直後、エラー処理中に届いた正常なバイトは失われない
+TEST(byte_after_framing_error_is_kept)
+{
+    Uart uart(USART2);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    serial.setErrorMarker(true, MARKER);
+
+    sim::rxByte(USART2, 'A');
+    sim::setBeforeErrorHook(USART2, [] { sim::rxByte(USART2, 'Y'); });
+    sim::rxByte(USART2, 'x', USART_SR_FE);
+    sim::setBeforeErrorHook(USART2, nullptr);
+    sim::rxByte(USART2, 'B');
+
+    CHECK_EQ(serial.read(), 'A');
+    CHECK_EQ(serial.read(), 'x');
+    CHECK_EQ(serial.read(), MARKER);
+    CHECK_EQ(serial.read(), 'Y');
+    CHECK_EQ(serial.read(), 'B');
+    CHECK_EQ(serial.read(), -1);
+    CHECK_EQ(serial.getErrorCounters().framing, 1u);
+}
+
+// ORE が残ったまま呼ばれた場合、DR にある正しいバイトを受け取ってからマーカーを入れる
+TEST(overrun_keeps_data_register_byte)
+{
+    Uart uart(USART2);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    serial.setErrorMarker(true, MARKER);
+
+    sim::isr([&] {
+        HAL_UART_AbortReceive(&uart.h);
+        USART2->DR.raw = 'W';
+        USART2->SR.raw |= USART_SR_RXNE | USART_SR_ORE;
+        uart.h.ErrorCode = HAL_UART_ERROR_ORE;
+        HAL_UART_ErrorCallback(&uart.h);
+    });
+
+    CHECK_EQ(serial.read(), 'W');
+    CHECK_EQ(serial.read(), MARKER);
+    CHECK_EQ(serial.read(), -1);
+    CHECK_EQ(serial.getErrorCounters().overrun, 1u);
+    CHECK(!(USART2->SR.raw & USART_SR_ORE));
+
+    // 受信は再開している
+    sim::rxByte(USART2, 'C');
+    CHECK_EQ(serial.read(), 'C');
+}
+
+// 割り込みが遅れて本物のオーバーランが起きた場合も、残ったバイトは順序どおり
+TEST(real_overrun_counts_and_recovers)
+{
+    Uart uart(USART2);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    __disable_irq();
+    sim::rxByte(USART2, '1');
+    sim::rxByte(USART2, '2');   // DR が埋まっているので失われる
+    __enable_irq();
+    sim::rxByte(USART2, '3');
+
+    CHECK_EQ(serial.read(), '1');
+    CHECK_EQ(serial.read(), '3');
+    CHECK_EQ(serial.read(), -1);
+    CHECK_EQ(serial.getErrorCounters().overrun, 1u);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file test_rx_frames.cpp
+ * @brief Frame boundaries from IDLE when the USART interrupt is serviced late.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <string>
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+
+std::string frame(STM32BufferedSerial& serial)
+{
+    uint8_t buf[32];
+    int n = serial.readFrame(buf, sizeof(buf));
+    return n > 0 ? std::string(reinterpret_cast<char*>(buf), static_cast<size_t>(n)) : std::string();
+}
+
+// 最後のバイトを受けた割り込みが 1 文字時間以上遅れ、RXNE と IDLE が同時に立った状態で入る
+void lateLastByte(uint8_t b)
+{
+    __disable_irq();
+    sim::rxByte(USART2, b);
+    sim::run(sim::byteTime(BAUD) * 3);
+    __enable_irq();
+}
+
+} // namespace
+
+// 遅れた割り込みでも、DR に残っていた最後のバイトはそのフレームに入る
+TEST(late_idle_keeps_last_byte_in_frame)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    sim::setIrqHook(USART2, [&] { serial.handleIrq(); });
+    serial.enableIdleDetection();
+
+    for (char c : std::string("abc")) sim::rxByte(USART2, static_cast<uint8_t>(c));
+    sim::run(sim::byteTime(BAUD) * 3);
+    sim::rxByte(USART2, 'd');
+    lateLastByte('e');
+    CHECK(sim::maxIrqLatencyNs() >= sim::byteTime(BAUD) * 2);
+
+    CHECK_EQ(serial.getIdleCount(), 2u);
+    CHECK_EQ(serial.nextFrameLength(), 3);
+    CHECK_EQ(frame(serial), std::string("abc"));
+    CHECK_EQ(frame(serial), std::string("de"));
+
+    // 次のバーストは独立したフレームになる
+    sim::rxByte(USART2, 'f');
+    sim::run(sim::byteTime(BAUD) * 3);
+    CHECK_EQ(frame(serial), std::string("f"));
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_rx_overflow_policy.cpp
+ * @brief Freshness and loss of the RX ring under overload, for the policy
+ *        selected by STM32BS_RX_OVERFLOW_POLICY (built once per policy).
+ *
+ * The remote side sends a numbered byte stream at line rate. Byte n carries n & 0xFF;
+ * the reader unwraps it back to n, which is exact as long as fewer than 256 bytes are
+ * lost between two reads.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+
+namespace {
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint16_t RING = 256;          // 容量 255 バイト
+constexpr uint16_t RTS_PIN = GPIO_PIN_1;
+
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_DROP_NEWEST
+const char* const POLICY = "DROP_NEWEST";
+#elif STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+const char* const POLICY = "OVERWRITE_OLDEST";
+#else
+const char* const POLICY = "THROTTLE";
+#endif
+
+// 連番を送る相手側。RTS が High の間は送信を止める（相手の UART の FIFO 分だけ遅れて止まる）
+struct Sender {
+    uint32_t next = 0;
+    uint32_t limit;
+    uint32_t lag = 2;
+    uint32_t pausedFor = 0;
+
+    explicit Sender(uint32_t n) : limit(n) {}
+
+    int operator()() {
+        if (next >= limit) return -1;
+        if (sim::pin(GPIOA, RTS_PIN)) {
+            if (pausedFor >= lag) return -1;
+            pausedFor++;
+        } else {
+            pausedFor = 0;
+        }
+        return static_cast<int>(next++ & 0xFF);
+    }
+};
+
+// 受信値を連番に戻す
+struct Unwrapper {
+    int64_t last = -1;
+    uint32_t operator()(uint8_t b) {
+        last += static_cast<uint8_t>(b - static_cast<uint8_t>(last) - 1) + 1;
+        return static_cast<uint32_t>(last);
+    }
+};
+
+void attach(Sender& sender)
+{
+    sim::setRxSource(USART2, BAUD, [&sender] { return sender(); });
+}
+
+} // namespace
+
+// 読まずに容量の倍以上を受け、あとで読んだ時に残っているのはどの区間か
+TEST(burst_keeps_policy_window)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+    serial.setRtsPin(GPIOA, RTS_PIN);
+
+    // 容量を超え、かつ最初に読む値が 1 周目に収まる長さ（連番に戻せるように）
+    const uint32_t N = 400;
+    Sender sender(N);
+    attach(sender);
+    sim::run(sim::byteTime(BAUD) * (N + 20));
+
+    Unwrapper seq;
+    int first = serial.read();
+    CHECK(first >= 0);
+    uint32_t firstSeq = seq(static_cast<uint8_t>(first));
+    uint32_t count = 1;
+    bool ordered = true;
+    uint32_t prev = firstSeq;
+    // THROTTLE では読んだ分だけ相手が送信を再開する
+    sim::runUntil([&] {
+        int c;
+        while ((c = serial.read()) >= 0) {
+            uint32_t s = seq(static_cast<uint8_t>(c));
+            if (s != prev + 1) ordered = false;
+            prev = s;
+            count++;
+        }
+        return sender.next >= N && serial.available() == 0;
+    }, 1000000000ull, sim::byteTime(BAUD));
+    // 最後の 1 バイトが届き切るのを待ってもう一度読む
+    sim::run(sim::byteTime(BAUD) * 2);
+    int c;
+    while ((c = serial.read()) >= 0) {
+        uint32_t s = seq(static_cast<uint8_t>(c));
+        if (s != prev + 1) ordered = false;
+        prev = s;
+        count++;
+    }
+
+    std::printf("  %-16s first read #%u (age %u bytes), delivered %u / %u, dropped %u\n",
+                POLICY, firstSeq, N - 1 - firstSeq, count, N,
+                static_cast<unsigned>(serial.getRxDropped()));
+
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_DROP_NEWEST
+    // 古い方が残り、溢れた新しいバイトが捨てられる
+    CHECK_EQ(firstSeq, 0u);
+    CHECK_EQ(count, static_cast<uint32_t>(serial.rxCapacity()));
+    CHECK(ordered);
+    CHECK_EQ(serial.getRxDropped(), N - count);
+#elif STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_OVERWRITE_OLDEST
+    // 新しい方が残る
+    CHECK_EQ(firstSeq, N - serial.rxCapacity());
+    CHECK_EQ(count, static_cast<uint32_t>(serial.rxCapacity()));
+    CHECK(ordered);
+    CHECK_EQ(prev, N - 1);
+    CHECK_EQ(serial.getRxDropped(), N - count);
+#else
+    // 相手を止めるので欠けずに全部届く
+    CHECK_EQ(firstSeq, 0u);
+    CHECK_EQ(count, N);
+    CHECK(ordered);
+    CHECK_EQ(serial.getRxDropped(), 0u);
+    CHECK(serial.getRxStallMs() > 0);
+#endif
+}
+
+// 読み出しが回線速度の半分しかない状態が続いたときの損失率と鮮度
+TEST(sustained_overload_loss_and_age)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, RING);
+    serial.begin();
+    serial.setRtsPin(GPIOA, RTS_PIN);
+
+    const uint32_t N = 4000;
+    Sender sender(N);
+    attach(sender);
+
+    Unwrapper seq;
+    uint32_t delivered = 0;
+    uint64_t ageSum = 0;
+    uint32_t ageMax = 0;
+    bool ordered = true;
+    int64_t prev = -1;
+    const uint64_t slot = sim::byteTime(BAUD);
+    const uint64_t deadline = slot * N * 4;
+    // 2 文字時間ごとに 1 バイト読む
+    while (sim::now() < deadline && delivered + serial.getRxDropped() < N) {
+        sim::run(2 * slot);
+        int c = serial.read();
+        if (c < 0) continue;
+        uint32_t s = seq(static_cast<uint8_t>(c));
+        if (static_cast<int64_t>(s) <= prev) ordered = false;
+        prev = s;
+        uint32_t age = sender.next - 1 - s;
+        ageSum += age;
+        if (age > ageMax) ageMax = age;
+        delivered++;
+    }
+
+    uint32_t dropped = serial.getRxDropped();
+    std::printf("  %-16s sent %u, delivered %u, dropped %u (%.1f%%), age mean %.1f ms max %.1f ms, stall %u ms\n",
+                POLICY, sender.next, delivered, dropped, 100.0 * dropped / sender.next,
+                delivered ? ageSum * slot / 1e6 / delivered : 0.0, ageMax * slot / 1e6,
+                static_cast<unsigned>(serial.getRxStallMs()));
+
+    CHECK(ordered);
+    CHECK_EQ(sender.next, N);
+    // 届いたか、捨てたと数えたかのどちらか（数え漏れが無い）
+    CHECK_EQ(delivered + dropped, N);
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_THROTTLE
+    CHECK_EQ(dropped, 0u);
+    CHECK(serial.getRxStallMs() > 0);
+#else
+    // 読み出し速度が半分なので、ほぼ半分が失われる
+    CHECK(dropped > N * 4 / 10 && dropped < N * 6 / 10);
+#if STM32BS_RX_OVERFLOW_POLICY == STM32BS_RX_DROP_NEWEST
+    // 空きができた時だけ受け取るので、リングの中身は読み出し速度で入れ替わる
+    CHECK(ageMax <= 2u * RING + 4u);
+#else
+    // リングには常に直近のバイトが入っている
+    CHECK(ageMax <= RING + 2u);
+#endif
+#endif
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test_send_buffer.cpp
+ * @brief sendBuffer(): ordering against ring writes, a single completion after the last
+ *        byte, and buffers larger than the TX ring (interrupt and DMA paths).
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <string>
+
+namespace {
+
+constexpr uint32_t BAUD = 1000000;
+constexpr uint32_t BUF_LEN = 600;   // TX リング（64）よりずっと大きい
+
+struct Done {
+    int calls = 0;
+    size_t wireAtCall = 0;   // 通知時点で回線に出終わっていたバイト数
+};
+
+void onDone(STM32BufferedSerial&, void* context)
+{
+    Done* d = static_cast<Done*>(context);
+    d->calls++;
+    d->wireAtCall = sim::wire(USART2).size();
+}
+
+void drain(STM32BufferedSerial& serial)
+{
+    sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * 2000, sim::byteTime(BAUD));
+}
+
+// 先に書いたリングのデータ → 外部バッファ → 送信中に書いたリングのデータ の順に出る
+void sendsInOrder(bool dma)
+{
+    Uart uart(USART2, BAUD);
+    DMA_HandleTypeDef dmaTx = {};
+    if (dma) uart.h.hdmatx = &dmaTx;
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    static uint8_t buf[BUF_LEN];
+    for (uint32_t i = 0; i < BUF_LEN; i++) buf[i] = static_cast<uint8_t>('a' + i % 26);
+
+    CHECK_EQ(serial.write(reinterpret_cast<const uint8_t*>("head:"), 5), 5);
+    Done done;
+    CHECK(serial.sendBuffer(buf, BUF_LEN, onDone, &done));
+
+    // 外部バッファの途中でリングに書く
+    sim::runUntil([] { return sim::wire(USART2).size() >= 100; }, sim::byteTime(BAUD) * 200, sim::byteTime(BAUD));
+    CHECK_EQ(done.calls, 0);
+    CHECK_EQ(serial.write(reinterpret_cast<const uint8_t*>(":tail"), 5), 5);
+    drain(serial);
+
+    std::string expect = "head:" + std::string(reinterpret_cast<const char*>(buf), BUF_LEN) + ":tail";
+    CHECK_EQ(wireString(USART2), expect);
+    CHECK_EQ(done.calls, 1);
+    // 最後のバイトが出た後、後続のリングのデータが出る前に通知される
+    CHECK_EQ(done.wireAtCall, static_cast<size_t>(5 + BUF_LEN));
+}
+
+} // namespace
+
+TEST(send_buffer_interrupt_path)
+{
+    sendsInOrder(false);
+}
+
+TEST(send_buffer_dma_path)
+{
+    sendsInOrder(true);
+}
+
+// 連続した外部バッファもそれぞれ 1 回ずつ、送った順に通知される
+TEST(back_to_back_buffers_complete_in_order)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    static const uint8_t first[] = "first buffer|";
+    static const uint8_t second[] = "second buffer";
+    Done d1, d2;
+    CHECK(serial.sendBuffer(first, sizeof(first) - 1, onDone, &d1));
+    CHECK(serial.sendBuffer(second, sizeof(second) - 1, onDone, &d2));
+    drain(serial);
+
+    CHECK_EQ(wireString(USART2), std::string("first buffer|second buffer"));
+    CHECK_EQ(d1.calls, 1);
+    CHECK_EQ(d2.calls, 1);
+    CHECK_EQ(d1.wireAtCall, sizeof(first) - 1);
+    CHECK_EQ(d2.wireAtCall, sizeof(first) - 1 + sizeof(second) - 1);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file test_stream.cpp
+ * @brief STM32BufferedSerialStreambuf: insertions never hold a TX reservation, extractions read the RX ring.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerialStream.hpp"
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace {
+
+constexpr uint32_t BAUD = 1000000;
+
+void drain(STM32BufferedSerial& serial)
+{
+    sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * 1000, sim::byteTime(BAUD));
+}
+
+} // namespace
+
+// 1 文字の挿入のあとでも、ほかの lane 0 の書き込みと printf() が通る
+TEST(char_insert_does_not_block_lane0)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    STM32BufferedSerialStreambuf buf(serial, false);
+    std::ostream out(&buf);
+
+    out << 'x';
+    CHECK_EQ(serial.write(reinterpret_cast<const uint8_t*>("yz"), 2), 2);
+    out << 7;
+    CHECK_EQ(serial.printf("%s", "ok"), 2);
+    // フラッシュしなくても送信される
+    drain(serial);
+    CHECK_EQ(wireString(USART2), std::string("xyz7ok"));
+}
+
+// 空きがなければ非ブロッキングでは失敗し、空けば続きを書ける
+TEST(nonblocking_insert_fails_when_full)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 32);
+    serial.begin();
+    serial.setCtsPin(GPIOA, GPIO_PIN_0);
+    sim::setPin(GPIOA, GPIO_PIN_0, true);
+    STM32BufferedSerialStreambuf buf(serial, false);
+    std::ostream out(&buf);
+
+    const uint8_t filler[31] = {};
+    CHECK_EQ(serial.write(filler, sizeof(filler)), 31);
+    CHECK_EQ(serial.writable_len(), 0);
+    out << 'a';
+    CHECK(out.bad());
+    out.clear();
+    sim::setPin(GPIOA, GPIO_PIN_0, false);
+    serial.handleCtsChange();
+    drain(serial);
+    out << 'b' << "cd";
+    CHECK(out.good());
+    drain(serial);
+    CHECK_EQ(wireString(USART2).substr(31), std::string("bcd"));
+}
+
+TEST(extract_from_rx_ring)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+    STM32BufferedSerialStreambuf buf(serial, false);
+    std::istream in(&buf);
+
+    for (char c : std::string("42 abc\n")) sim::rxByte(USART2, static_cast<uint8_t>(c));
+    int v = 0;
+    std::string word;
+    in >> v >> word;
+    CHECK_EQ(v, 42);
+    CHECK_EQ(word, std::string("abc"));
+    in.sync();
+    // 読んだ分だけリングから消費されている
+    CHECK_EQ(serial.readable_len(), 1);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file test_tx_done.cpp
+ * @brief write(..., done, ctx): the callback fires once, when the message's last byte has
+ *        left the wire (not when it is queued), across the ring wrap and with a full marker queue.
+ */
+
+#include "test.hpp"
+#include "fixture.hpp"
+#include "STM32BufferedSerial.hpp"
+#include <string>
+
+namespace {
+
+constexpr uint32_t BAUD = 1000000;
+
+struct Done {
+    int calls = 0;
+    size_t wireAtCall = 0;   // 通知時点で回線に出終わっていたバイト数
+};
+
+void onDone(STM32BufferedSerial&, void* context)
+{
+    Done* d = static_cast<Done*>(context);
+    d->calls++;
+    d->wireAtCall = sim::wire(USART2).size();
+}
+
+void drain(STM32BufferedSerial& serial)
+{
+    sim::runUntil([&] { return serial.isTxIdle(); }, sim::byteTime(BAUD) * 1000, sim::byteTime(BAUD));
+}
+
+const uint8_t* bytes(const char* s)
+{
+    return reinterpret_cast<const uint8_t*>(s);
+}
+
+} // namespace
+
+// キューに入れた時点では呼ばれず、各メッセージの最後のバイトが出た時に 1 回だけ呼ばれる
+TEST(done_fires_after_last_byte_of_each_message)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    Done d1, d2;
+    CHECK_EQ(serial.write(bytes("request-1|"), 10, onDone, &d1), 10);
+    CHECK_EQ(serial.write(bytes("plain|"), 6), 6);
+    CHECK_EQ(serial.write(bytes("request-2"), 9, onDone, &d2), 9);
+    CHECK_EQ(d1.calls, 0);
+    CHECK_EQ(d2.calls, 0);
+
+    // 1 通目の途中ではまだ呼ばれない
+    sim::runUntil([] { return sim::wire(USART2).size() >= 9; }, sim::byteTime(BAUD) * 20, sim::byteTime(BAUD) / 4);
+    CHECK_EQ(d1.calls, 0);
+
+    drain(serial);
+    CHECK_EQ(wireString(USART2), std::string("request-1|plain|request-2"));
+    CHECK_EQ(d1.calls, 1);
+    CHECK_EQ(d1.wireAtCall, 10u);
+    CHECK_EQ(d2.calls, 1);
+    CHECK_EQ(d2.wireAtCall, 25u);
+}
+
+// リングの折り返しをまたぐメッセージでも最後のバイトで通知される
+TEST(done_fires_for_message_across_ring_wrap)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 64);
+    serial.begin();
+
+    std::string first(40, 'x');
+    CHECK_EQ(serial.write(bytes(first.c_str()), 40), 40);
+    drain(serial);
+
+    std::string second;
+    for (int i = 0; i < 40; i++) second.push_back(static_cast<char>('a' + i % 26));
+    Done d;
+    CHECK_EQ(serial.write(bytes(second.c_str()), 40, onDone, &d), 40);
+    CHECK_EQ(d.calls, 0);
+    drain(serial);
+
+    CHECK_EQ(wireString(USART2), first + second);
+    CHECK_EQ(d.calls, 1);
+    CHECK_EQ(d.wireAtCall, 80u);
+}
+
+// 区切りキューが満杯なら書き込みごと断り、受け付けた分はすべて 1 回ずつ通知される
+TEST(full_marker_queue_rejects_message)
+{
+    Uart uart(USART2, BAUD);
+    STM32BufferedSerial serial(&uart.h, 256);
+    serial.begin();
+    serial.setCtsPin(GPIOA, GPIO_PIN_0);
+    sim::setPin(GPIOA, GPIO_PIN_0, true);   // CTS で送信を止めておく
+
+    Done d[STM32BS_TX_MARKERS];
+    int accepted = 0;
+    for (int i = 0; i < STM32BS_TX_MARKERS; i++) {
+        if (serial.write(bytes("msg|"), 4, onDone, &d[i]) == 4) accepted++;
+    }
+    CHECK_EQ(accepted, STM32BS_TX_MARKERS - 1);
+
+    sim::setPin(GPIOA, GPIO_PIN_0, false);
+    serial.handleCtsChange();
+    drain(serial);
+
+    CHECK_EQ(wireString(USART2).size(), static_cast<size_t>(4 * accepted));
+    for (int i = 0; i < accepted; i++) {
+        CHECK_EQ(d[i].calls, 1);
+        CHECK_EQ(d[i].wireAtCall, static_cast<size_t>(4 * (i + 1)));
+    }
+    CHECK_EQ(d[STM32BS_TX_MARKERS - 1].calls, 0);
+}
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""Decode STM32BS_LOG() binary records back into text.
+
+The format strings are read from the ``.stm32bs_log`` section of the firmware
+ELF file; the record stream comes from a capture file, stdin or a serial port.
+
+    stm32bs_logdecode.py firmware.elf capture.bin
+    stm32bs_logdecode.py firmware.elf --port /dev/ttyUSB0 --baud 921600   (needs pyserial)
+
+Record layout (see STM32BufferedSerial::logRecord()):
+    0xA5  len:u8  id:u16le  args...  crc:u16le
+    len counts id and args; crc is CRC-16/MODBUS over len, id and args
+    integers / pointers: 4 bytes (8 for ll / j), float: 4 bytes, string: u8 length + bytes
+
+Bytes that do not form a record with a valid CRC are skipped one at a time until
+the next sync byte that does, so a lost or corrupted byte costs only the records
+it touches. Skipped byte counts are reported on stderr.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SECTION = ".stm32bs_log"
+SYNC = 0xA5
+
+# printf 変換指定（% の後ろ）: フラグ・幅・精度・長さ修飾子・変換文字
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t)?([diuxXocspfFeEgG%])")
+
+
+def load_strings(elf_path):
+    """Return {id: format string} from the ELF section."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        raise SystemExit(f"{elf_path}: not an ELF file")
+    is64 = elf[4] == 2
+    end = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(end + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x3A)
+        fmt = end + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(end + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x2E)
+        fmt = end + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(fmt, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    names_off = names[4]
+
+    def name_of(sh):
+        start = names_off + sh[0]
+        return elf[start:elf.index(b"\0", start)].decode()
+
+    for sh in sections:
+        if name_of(sh) != SECTION:
+            continue
+        addr, offset, size = sh[3], sh[4], sh[5]
+        data = elf[offset:offset + size]
+        strings = {}
+        pos = 0
+        while pos < len(data):
+            if data[pos] == 0:          # 配置のための詰め物
+                pos += 1
+                continue
+            stop = data.index(b"\0", pos)
+            strings[(addr + pos) & 0xFFFF] = data[pos:stop].decode("utf-8", "replace")
+            pos = stop + 1
+        return strings
+    raise SystemExit(f"{elf_path}: no {SECTION} section (no STM32BS_LOG() calls linked?)")
+
+
+class Args:
+    def __init__(self, payload):
+        self.data = payload
+        self.pos = 0
+
+    def take(self, n):
+        if self.pos + n > len(self.data):
+            raise ValueError("record too short")
+        chunk = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return chunk
+
+    def int(self, size, signed):
+        return int.from_bytes(self.take(size), "little", signed=signed)
+
+    def float(self):
+        return struct.unpack("<f", self.take(4))[0]
+
+    def string(self):
+        n = self.take(1)[0]
+        return self.take(n).decode("utf-8", "replace")
+
+
+def render(fmt, args):
+    """Apply the arguments to a C format string using Python's % operator."""
+    out = []
+    last = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        values = []
+        if width == "*":
+            width = str(args.int(4, True))
+        if prec == "*":
+            prec = str(args.int(4, True))
+        size = 8 if length in ("ll", "j") else 4
+        if conv in "di":
+            values.append(args.int(size, True))
+        elif conv in "uxXo":
+            values.append(args.int(size, False))
+        elif conv == "c":
+            values.append(chr(args.int(4, False) & 0xFF))
+        elif conv == "p":
+            values.append(args.int(4, False))
+            conv = "x"
+            flags = "#" + flags
+        elif conv == "s":
+            values.append(args.string())
+        else:
+            values.append(args.float())
+        spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "") + conv
+        out.append(spec % tuple(values))
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def crc16_modbus(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def records(stream):
+    """Yield (id, payload, skipped) for each valid record; skipped = bytes dropped before it."""
+    buf = bytearray()
+    skipped = 0
+    eof = False
+
+    def fill(n):
+        nonlocal eof
+        while len(buf) < n and not eof:
+            more = stream.read(n - len(buf))
+            if more:
+                buf.extend(more)
+            else:
+                eof = True
+        return len(buf) >= n
+
+    while fill(1):
+        # 同期バイト・長さ・CRC のどれかが合わなければ 1 バイトずらして探し直す
+        ok = buf[0] == SYNC and fill(2) and buf[1] >= 2 and fill(buf[1] + 4)
+        if ok:
+            n = buf[1]
+            body = bytes(buf[1:n + 2])
+            ok = crc16_modbus(body) == (buf[n + 2] | (buf[n + 3] << 8))
+        if not ok:
+            del buf[0]
+            skipped += 1
+            continue
+        del buf[:n + 4]
+        yield body[1] | (body[2] << 8), body[3:], skipped
+        skipped = 0
+    if skipped:
+        print(f"<skipped {skipped} trailing bytes>", file=sys.stderr)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("elf", help="firmware ELF containing the .stm32bs_log section")
+    ap.add_argument("capture", nargs="?", help="binary capture file (default: stdin)")
+    ap.add_argument("--port", help="read from a serial port instead (requires pyserial)")
+    ap.add_argument("--baud", type=int, default=115200)
+    opts = ap.parse_args()
+
+    strings = load_strings(opts.elf)
+    if opts.port:
+        import serial
+        stream = serial.Serial(opts.port, opts.baud)
+    elif opts.capture:
+        stream = open(opts.capture, "rb")
+    else:
+        stream = sys.stdin.buffer
+
+    for rid, payload, skipped in records(stream):
+        if skipped:
+            print(f"<skipped {skipped} bytes>", file=sys.stderr, flush=True)
+        fmt = strings.get(rid)
+        if fmt is None:
+            print(f"<unknown id 0x{rid:04x}: {payload.hex()}>")
+            continue
+        try:
+            print(render(fmt, Args(payload)), flush=True)
+        except (ValueError, TypeError) as e:
+            print(f"<bad record for {fmt!r}: {e}: {payload.hex()}>")
+
+
+if __name__ == "__main__":
+    main()